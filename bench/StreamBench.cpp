@@ -0,0 +1,340 @@
+// Générateur de charge pour les flux MJPEG du serveur.
+// Ouvre N connexions simultanées (réparties sur les chemins donnés), découpe le
+// flux multipart/x-mixed-replace et mesure pour chaque client : images reçues
+// par seconde, gigue entre images, débit et délai avant la première image.
+//
+//   StreamBench [-h hôte] [-p port] [-n connexions] [-d secondes] [-r rampe_ms] [chemin...]
+//   StreamBench -n 20 -d 30 /video1 /video2 /disparityStream
+//
+// Sans caméra, lancer le serveur avec des mires générées : WebcamStreamer --synthetic
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Lecture bufferisée d'une socket, par ligne ou par nombre d'octets
+class SocketReader {
+
+    public:
+
+    SocketReader(int fd, const std::atomic<bool>& running) : fd(fd), running(running), begin(0), end(0), total(0) {}
+
+    // Ligne sans "\r\n" ; false si la connexion est fermée
+    bool readLine(std::string& line) {
+        line.clear();
+        while (true) {
+            if (begin == end && !fill()) return false;
+            char* start = buffer + begin;
+            char* newline = (char*)memchr(start, '\n', end - begin);
+            if (newline == nullptr) {
+                line.append(start, end - begin);
+                begin = end;
+                continue;
+            }
+            line.append(start, newline - start);
+            begin += newline - start + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return true;
+        }
+    }
+
+    // Consomme size octets (le contenu des images n'est pas conservé)
+    bool skip(size_t size) {
+        while (size > 0) {
+            if (begin == end && !fill()) return false;
+            size_t chunk = std::min(size, end - begin);
+            begin += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    size_t bytesRead() const { return total; }
+
+    private:
+
+    bool fill() {
+        while (running) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                begin = 0;
+                end = n;
+                total += n;
+                return true;
+            }
+            // Délai de réception écoulé : vérifie la fin du test puis recommence
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+            return false;
+        }
+        return false;
+    }
+
+    int fd;
+    const std::atomic<bool>& running;
+    char buffer[64 * 1024];
+    size_t begin;
+    size_t end;
+    size_t total;
+};
+
+// Mesures d'une connexion
+struct ClientStats {
+    std::string path;
+    std::string error;
+    size_t frames = 0;
+    size_t uniqueFrames = 0;        // Numéros X-Frame-Seq différents du précédent
+    size_t bytes = 0;
+    double firstFrame = -1;         // Secondes depuis le début de la connexion
+    double duration = 0;            // Secondes entre la connexion et la fin du test
+    double lastFrame = 0;
+    double intervalSum = 0;         // Intervalles entre images (secondes)
+    double intervalSquares = 0;
+    double maxInterval = 0;
+    double latencySum = 0;          // Heure de réception - X-Capture-Timestamp (secondes)
+    size_t latencyCount = 0;
+
+    double fps() const {
+        double active = lastFrame - firstFrame;
+        return frames > 1 && active > 0 ? (frames - 1) / active : 0;
+    }
+    double uniqueFps() const {
+        return frames > 0 ? fps() * uniqueFrames / frames : 0;
+    }
+    double jitterMs() const {
+        if (frames < 3) return 0;
+        double n = frames - 1;
+        double mean = intervalSum / n;
+        return 1000 * std::sqrt(std::max(0.0, intervalSquares / n - mean * mean));
+    }
+    double bytesPerSecond() const { return duration > 0 ? bytes / duration : 0; }
+    double latencyMs() const { return latencyCount > 0 ? 1000 * latencySum / latencyCount : -1; }
+};
+
+static int connectTo(const std::string& host, const std::string& port, std::string& error) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = nullptr;
+    int result = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+    if (result != 0) {
+        error = gai_strerror(result);
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* address = addresses ; address != nullptr ; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) error = std::string("connexion impossible : ") + strerror(errno);
+    return fd;
+}
+
+static std::string headerValue(const std::string& line, const char* name) {
+    size_t length = strlen(name);
+    if (line.size() <= length || strncasecmp(line.c_str(), name, length) != 0 || line[length] != ':') return "";
+    size_t start = line.find_first_not_of(' ', length + 1);
+    return start == std::string::npos ? "" : line.substr(start);
+}
+
+// Une connexion : requête, en-têtes, puis découpage des parties jusqu'à la fin du test
+static void runClient(const std::string& host, const std::string& port, ClientStats& stats,
+                      const std::atomic<bool>& running) {
+    Clock::time_point start = Clock::now();
+    int fd = connectTo(host, port, stats.error);
+    if (fd < 0) return;
+
+    // Délai de réception court : le client s'arrête avec le test même si le flux est figé
+    struct timeval timeout = {0, 200000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string request = "GET " + stats.path + " HTTP/1.1\r\n"
+                          "Host: " + host + ":" + port + "\r\n"
+                          "Connection: close\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    SocketReader reader(fd, running);
+    std::string line;
+    std::string boundary;
+
+    // Ligne de statut et en-têtes de la réponse
+    if (!reader.readLine(line) || line.find(" 200") == std::string::npos) {
+        stats.error = line.empty() ? "pas de réponse" : line;
+    } else {
+        while (reader.readLine(line) && !line.empty()) {
+            std::string contentType = headerValue(line, "Content-Type");
+            size_t position = contentType.find("boundary=");
+            if (position != std::string::npos) boundary = "--" + contentType.substr(position + 9);
+        }
+        if (boundary.empty()) stats.error = "pas un flux multipart";
+    }
+
+    uint64_t previousSeq = 0;
+    while (stats.error.empty() && running) {
+        // Délimiteur de la partie suivante
+        if (!reader.readLine(line)) break;
+        if (line != boundary) continue;
+
+        long contentLength = -1;
+        bool hasSeq = false;
+        uint64_t seq = 0;
+        while (reader.readLine(line) && !line.empty()) {
+            std::string value;
+            if (!(value = headerValue(line, "Content-Length")).empty()) {
+                contentLength = atol(value.c_str());
+            } else if (!(value = headerValue(line, "X-Frame-Seq")).empty()) {
+                seq = strtoull(value.c_str(), nullptr, 10);
+                hasSeq = true;
+            } else if (!(value = headerValue(line, "X-Capture-Timestamp")).empty()) {
+                // Même machine : l'horloge murale du serveur est comparable
+                int64_t captured = atoll(value.c_str());
+                int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch()).count();
+                if (captured > 0) {
+                    stats.latencySum += (now - captured) / 1e6;
+                    stats.latencyCount++;
+                }
+            }
+        }
+        if (contentLength < 0) {
+            if (running) stats.error = "partie sans Content-Length";
+            break;
+        }
+        if (!reader.skip(contentLength)) break;
+
+        double received = secondsSince(start, Clock::now());
+        if (stats.frames == 0) {
+            stats.firstFrame = received;
+        } else {
+            double interval = received - stats.lastFrame;
+            stats.intervalSum += interval;
+            stats.intervalSquares += interval * interval;
+            stats.maxInterval = std::max(stats.maxInterval, interval);
+        }
+        stats.lastFrame = received;
+        stats.frames++;
+        if (!hasSeq || seq != previousSeq || stats.frames == 1) stats.uniqueFrames++;
+        previousSeq = seq;
+    }
+
+    stats.duration = secondsSince(start, Clock::now());
+    stats.bytes = reader.bytesRead();
+    close(fd);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage : %s [-h hôte] [-p port] [-n connexions] [-d secondes] [-r rampe_ms] [chemin...]\n"
+            "  Chemins par défaut : /video1 (première caméra). Les connexions sont réparties à tour de rôle.\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    std::string host = "localhost";
+    std::string port = "8080";
+    int connections = 10;
+    double duration = 10;
+    int rampMs = 0;
+    std::vector<std::string> paths;
+
+    for (int i = 1 ; i < argc ; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-h" && hasValue) host = argv[++i];
+        else if (arg == "-p" && hasValue) port = argv[++i];
+        else if (arg == "-n" && hasValue) connections = atoi(argv[++i]);
+        else if (arg == "-d" && hasValue) duration = atof(argv[++i]);
+        else if (arg == "-r" && hasValue) rampMs = atoi(argv[++i]);
+        else if (!arg.empty() && arg[0] == '/') paths.push_back(arg);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (paths.empty()) paths.push_back("/video1");
+    if (connections < 1 || duration <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("%d connexions vers %s:%s pendant %.0f s\n", connections, host.c_str(), port.c_str(), duration);
+
+    std::atomic<bool> running(true);
+    std::vector<ClientStats> stats(connections);
+    std::vector<std::thread> threads;
+    for (int i = 0 ; i < connections ; i++) {
+        stats[i].path = paths[i % paths.size()];
+        threads.emplace_back(runClient, host, port, std::ref(stats[i]), std::cref(running));
+        // Montée en charge progressive
+        if (rampMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(rampMs));
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+    running = false;
+    for (std::thread& thread : threads) thread.join();
+
+    // Détail par client
+    printf("\n%4s  %-20s %7s %8s %8s %9s %9s %10s %9s %10s\n",
+           "id", "chemin", "images", "ips", "ips_uniq", "gigue_ms", "max_ms", "ko/s", "ttff_ms", "latence_ms");
+    int failures = 0;
+    for (int i = 0 ; i < connections ; i++) {
+        const ClientStats& client = stats[i];
+        if (!client.error.empty() && client.frames == 0) {
+            printf("%4d  %-20s erreur : %s\n", i, client.path.c_str(), client.error.c_str());
+            failures++;
+            continue;
+        }
+        printf("%4d  %-20s %7zu %8.2f %8.2f %9.2f %9.1f %10.1f %9.1f %10.1f\n",
+               i, client.path.c_str(), client.frames, client.fps(), client.uniqueFps(), client.jitterMs(),
+               1000 * client.maxInterval, client.bytesPerSecond() / 1024,
+               client.firstFrame >= 0 ? 1000 * client.firstFrame : -1.0, client.latencyMs());
+    }
+
+    // Synthèse par chemin
+    printf("\n%-20s %8s %10s %10s %10s %10s %10s\n",
+           "chemin", "clients", "ips_moy", "ips_min", "gigue_moy", "Mo/s", "ttff_max");
+    for (const std::string& path : paths) {
+        int clients = 0;
+        double fpsSum = 0, fpsMin = 1e9, jitterSum = 0, bytesPerSecond = 0, ttffMax = 0;
+        for (const ClientStats& client : stats) {
+            if (client.path != path || client.frames == 0) continue;
+            clients++;
+            fpsSum += client.fps();
+            fpsMin = std::min(fpsMin, client.fps());
+            jitterSum += client.jitterMs();
+            bytesPerSecond += client.bytesPerSecond();
+            ttffMax = std::max(ttffMax, 1000 * client.firstFrame);
+        }
+        if (clients == 0) {
+            printf("%-20s %8d  aucune image reçue\n", path.c_str(), 0);
+            continue;
+        }
+        printf("%-20s %8d %10.2f %10.2f %10.2f %10.2f %10.1f\n", path.c_str(), clients,
+               fpsSum / clients, fpsMin, jitterSum / clients, bytesPerSecond / (1024 * 1024), ttffMax);
+    }
+
+    if (failures > 0) printf("\n%d connexion(s) sans image\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+# Génère un fichier C++ contenant les fichiers de resources/ : contenu brut,
+# variante gzip (si elle est plus petite) et ETag (début du SHA1 du contenu).
+# Appelé pendant la compilation :
+#   cmake -DRESOURCE_DIR=... -DOUTPUT=... [-DGZIP=/usr/bin/gzip] -P EmbedResources.cmake
+
+get_filename_component(OUTPUT_DIR ${OUTPUT} DIRECTORY)
+file(GLOB RESOURCE_FILES "${RESOURCE_DIR}/*")
+list(SORT RESOURCE_FILES)
+
+# Tableau C d'octets à partir du contenu hexadécimal ; un zéro final évite les tableaux vides
+function(hex_to_array hex result)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+    set(${result} "${bytes}0x00" PARENT_SCOPE)
+endfunction()
+
+set(CONTENT "// Fichier généré par cmake/EmbedResources.cmake, ne pas modifier\n")
+set(CONTENT "${CONTENT}#include \"StaticResources.hpp\"\n\n")
+set(ENTRIES "")
+set(INDEX 0)
+
+foreach(FILE ${RESOURCE_FILES})
+    get_filename_component(NAME ${FILE} NAME)
+    get_filename_component(EXTENSION ${FILE} EXT)
+
+    if(EXTENSION STREQUAL ".html")
+        set(TYPE "text/html; charset=utf-8")
+    elseif(EXTENSION STREQUAL ".js")
+        set(TYPE "application/javascript")
+    elseif(EXTENSION STREQUAL ".css")
+        set(TYPE "text/css")
+    elseif(EXTENSION STREQUAL ".json")
+        set(TYPE "application/json")
+    elseif(EXTENSION STREQUAL ".svg")
+        set(TYPE "image/svg+xml")
+    elseif(EXTENSION STREQUAL ".png")
+        set(TYPE "image/png")
+    elseif(EXTENSION STREQUAL ".ico")
+        set(TYPE "image/x-icon")
+    else()
+        set(TYPE "application/octet-stream")
+    endif()
+
+    file(READ ${FILE} HEX HEX)
+    string(LENGTH "${HEX}" HEX_LENGTH)
+    math(EXPR SIZE "${HEX_LENGTH} / 2")
+    hex_to_array("${HEX}" BYTES)
+    set(CONTENT "${CONTENT}static const unsigned char resource${INDEX}[] = {${BYTES}};\n")
+
+    # Variante gzip (-n : sans nom ni date, le fichier généré ne change que si la ressource change)
+    set(GZIP_DATA "nullptr")
+    set(GZIP_SIZE 0)
+    if(GZIP)
+        set(GZIP_FILE "${OUTPUT_DIR}/${NAME}.gz")
+        execute_process(COMMAND ${GZIP} -9 -n -c ${FILE} OUTPUT_FILE ${GZIP_FILE} RESULT_VARIABLE GZIP_RESULT)
+        if(GZIP_RESULT EQUAL 0)
+            file(READ ${GZIP_FILE} GZIP_HEX HEX)
+            string(LENGTH "${GZIP_HEX}" GZIP_HEX_LENGTH)
+            math(EXPR COMPRESSED_SIZE "${GZIP_HEX_LENGTH} / 2")
+            if(COMPRESSED_SIZE LESS SIZE)
+                hex_to_array("${GZIP_HEX}" GZIP_BYTES)
+                set(CONTENT "${CONTENT}static const unsigned char resource${INDEX}_gz[] = {${GZIP_BYTES}};\n")
+                set(GZIP_DATA "resource${INDEX}_gz")
+                set(GZIP_SIZE ${COMPRESSED_SIZE})
+            endif()
+        endif()
+        file(REMOVE ${GZIP_FILE})
+    endif()
+
+    file(SHA1 ${FILE} HASH)
+    string(SUBSTRING ${HASH} 0 16 ETAG)
+
+    # Chaque encodage a son ETag : les deux corps sont différents
+    if(GZIP_SIZE GREATER 0)
+        set(GZIP_ETAG "\"\\\"${ETAG}-gz\\\"\"")
+    else()
+        set(GZIP_ETAG "nullptr")
+    endif()
+
+    set(ENTRIES "${ENTRIES}    {\"${NAME}\", \"${TYPE}\", resource${INDEX}, ${SIZE}, ${GZIP_DATA}, ${GZIP_SIZE}, \"\\\"${ETAG}\\\"\", ${GZIP_ETAG}},\n")
+    math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+set(CONTENT "${CONTENT}\nconst EmbeddedResource EMBEDDED_RESOURCES[] = {\n${ENTRIES}")
+set(CONTENT "${CONTENT}    {nullptr, nullptr, nullptr, 0, nullptr, 0, nullptr, nullptr}\n};\n\n")
+set(CONTENT "${CONTENT}const size_t NB_EMBEDDED_RESOURCES = ${INDEX};\n")
+
+# Réécrit seulement si le contenu change, pour ne pas tout recompiler
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} PREVIOUS)
+endif()
+if(NOT "${PREVIOUS}" STREQUAL "${CONTENT}")
+    file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RectificationContext.hpp"
+#include "StereoRecorder.hpp"
+
+// Paramètres du mode batch (ligne de commande)
+struct BatchConfig {
+    std::string input;        // Dossier de paires d'images ou enregistrement .pvrec
+    std::string output;       // Dossier des résultats
+    std::string calibration;  // stereo_calib.yml ou bundle .bin
+    bool census = false;      // CensusMatcher au lieu de StereoBM
+    bool depth = false;       // Profondeur en plus de la disparité
+    int threads = 0;          // 0 : un thread par cœur
+};
+
+// Calcul de la disparité hors ligne, sans serveur HTTP : toutes les paires d'un
+// dossier (xxx-left / xxx-right, pair-NNNN-camera1 / pair-NNNN-camera2 du stock de
+// calibration, ou l'ancien camera0-N / camera1-N) ou d'un
+// enregistrement sont rectifiées et appariées avec la même calibration. Chaque
+// thread traite des images entières, avec son propre moteur et ses buffers.
+// Sorties par paire : NNNNNN-disparity.png (16 bits, disparité x16, 0 si invalide)
+// et NNNNNN-depth.png (16 bits, millimètres), plus summary.json.
+class BatchDisparity {
+
+    public:
+
+    BatchDisparity(const BatchConfig& config);
+
+    // Traite toutes les paires et retourne le code de sortie du programme
+    int run();
+
+    private:
+
+    // Paire à traiter : deux fichiers, ou deux indices dans l'enregistrement
+    struct BatchItem {
+        std::string name;  // Préfixe des fichiers de sortie
+        std::string files[2];
+        long frames[2];
+    };
+
+    // Temps cumulés par étape (microsecondes)
+    enum BatchStep { STEP_READ = 0, STEP_RECTIFY, STEP_MATCH, STEP_WRITE, NB_BATCH_STEPS };
+
+    bool listDirectory();
+    bool listRecording();
+    bool readPair(const BatchItem& item, cv::Mat& left, cv::Mat& right);
+    void worker();
+    void writeDepth(const cv::Mat& disparity16, cv::Mat& depth, const std::string& filename);
+    std::string summaryJson(double seconds, int threads) const;
+
+    BatchConfig config;
+    std::vector<BatchItem> items;
+    std::shared_ptr<const RecordingReader> recording;
+    std::shared_ptr<const RectificationContext> ctx;
+
+    std::atomic<size_t> next;
+    std::atomic<long> done;
+    std::atomic<long> failed;
+    std::atomic<long> stepMicros[NB_BATCH_STEPS];
+};
@@ -5,21 +5,40 @@
 #include <thread>
 #include <iostream>
 #include <filesystem>
+#include <memory>
+#include <atomic>
+#include <chrono>
 
 #include "commons.hpp"
-#include "IndexController.hpp"
+#include "CaptureManager.hpp"
+#include "DisparityController.hpp"
+#include "StreamDemand.hpp"
+#include "RectificationContext.hpp"
+#include "FramePool.hpp"
+#include "StaticResources.hpp"
+#include "TaskScheduler.hpp"
+#include "CalibrationStore.hpp"
+#include "PoseCoverage.hpp"
+#include "FrameTracer.hpp"
+#include "EncodeService.hpp"
 
 namespace fs = std::filesystem;
 
+// Calibration d'une paire stéréo
 class CalibrationController {
 
     public:
 
-    CalibrationController(struct mg_context* ctx, IndexController* indexCtrl);
+    CalibrationController(struct mg_context* ctx, CaptureManager* captureManager,
+                          const StereoPairConfig& pair, DisparityController* disparityCtrl,
+                          bool legacyRoutes);
     ~CalibrationController();
 
-    // Threads de caméra
-    void static calibThread(int camID);
+    // Fin des handlers en cours, avant mg_stop ; le destructeur vient après
+    void stop();
+
+    // Thread qui répartit la détection des échiquiers sur le pool de calcul
+    void calibThread();
 
     // Handlers
     static int streamHandler(struct mg_connection *conn, void *param);
@@ -27,30 +46,68 @@ class CalibrationController {
     static int saveButtonHandler(struct mg_connection *conn, void *param);
     static int calibrateButtonHandler(struct mg_connection *conn, void *param);
     static int eraseButtonHandler(struct mg_connection *conn, void *param);
-
-    int nbImagesInMemory();
-    int nbImagesInMemoryByCamID(int camID);
+    static int autoCaptureHandler(struct mg_connection *conn, void *param);
 
     private:
 
-    static void calibrateCameras();
+    void calibrateCameras();
     static void saveCalibration(const std::string& filename,
                      const cv::Mat& cameraMatrix1, const cv::Mat& distCoeffs1,
                      const cv::Mat& cameraMatrix2, const cv::Mat& distCoeffs2,
-                     const cv::Mat& R, const cv::Mat& T);
-    static void eraseFrames();
-    static void saveFrames();
-
-    static int boardWidth, boardHeight;
-    static float squareSize;
-    
-    static std::thread calibThread1;
-    static std::thread calibThread2;
-    static cv::Size boardSize;
-    static IndexController* indexCtrl;
-    static std::mutex chessboardMutexes[NB_WEBCAMS];
-    static cv::Mat chessboards[NB_WEBCAMS];
-    static int cameraID[NB_WEBCAMS];
-    static bool running, capturing;
-    static int nbImages;
+                     const cv::Mat& R, const cv::Mat& T, const cv::Size& imageSize);
+    void eraseFrames();
+    int saveFrames();
+    void detectChessboard(int side);
+
+    // Capture automatique des couples qui améliorent la couverture des poses
+    void setAutoCapture(bool enable);
+    void autoCaptureStep();
+    std::string autoCaptureJson();
+
+    // Paramètre des handlers de flux : une caméra de la paire
+    struct StreamParam {
+        CalibrationController* ctrl;
+        int side;
+        int encodeID;  // Flux du service d'encodage
+    };
+
+    int boardWidth, boardHeight;
+    float squareSize;
+
+    StereoPairConfig pair;
+    std::string imagesDir;
+    std::string calibrationDir;
+    std::thread detectionThread;
+    cv::Size boardSize;
+    CaptureManager* captureManager;
+    DisparityController* disparityCtrl;
+    std::mutex chessboardMutexes[STEREO_CAMERAS];
+    cv::Mat chessboards[STEREO_CAMERAS];
+    FrameInfo chessboardInfos[STEREO_CAMERAS];
+    std::unique_ptr<StreamDemand> chessboardDemand;
+    std::unique_ptr<StreamDemand> chessboardDemands[STEREO_CAMERAS];
+
+    // Buffers de travail de la détection, conservés d'une image à l'autre
+    cv::Mat detectionFrames[STEREO_CAMERAS];
+    cv::Mat detectionGrays[STEREO_CAMERAS];
+    std::vector<cv::Point2f> detectionCorners[STEREO_CAMERAS];
+    bool detectionFound[STEREO_CAMERAS];
+    FrameInfo detectionInfos[STEREO_CAMERAS];
+    const char* detectionTraces[STEREO_CAMERAS];
+    StreamParam streamParams[STEREO_CAMERAS];
+    int cameraID[STEREO_CAMERAS];
+    bool running, capturing;
+
+    // Images de calibration enregistrées et leur manifeste
+    std::unique_ptr<CalibrationStore> store;
+
+    // Capture automatique : les abonnements maintiennent la détection sur les deux caméras
+    std::mutex autoCaptureMutex;
+    std::atomic<bool> autoCapture;
+    PoseCoverage coverage;
+    BoardPose lastPose;
+    bool lastPoseValid;
+    int autoSaved;
+    std::chrono::steady_clock::time_point lastAutoSave;
+    std::unique_ptr<StreamDemand::Subscription> autoSubscriptions[STEREO_CAMERAS + 1];
 };
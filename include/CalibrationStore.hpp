@@ -0,0 +1,88 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "commons.hpp"
+
+// Etat de la détection de l'échiquier sur une image enregistrée
+enum DetectionStatus {
+    DETECTION_PENDING = -1,  // Pas encore cherché (image importée)
+    DETECTION_NOT_FOUND = 0,
+    DETECTION_FOUND = 1
+};
+
+// Couple d'images de calibration et résultat de la détection
+struct CalibrationPair {
+    int id;
+    double timestamp;                                   // Secondes depuis l'epoch
+    cv::Size imageSize;
+    std::string files[STEREO_CAMERAS];                  // Relatifs au dossier du stock
+    int detection[STEREO_CAMERAS];
+    std::vector<cv::Point2f> corners[STEREO_CAMERAS];
+};
+
+// Stock des images de calibration d'une paire. Le manifeste (manifest.yml)
+// décrit chaque couple : il est seul lu au démarrage, sans parcourir le
+// dossier ni relire d'image. Les images sont écrites en PNG (sans perte) et
+// l'échiquier y est cherché par un thread d'écriture, jamais dans le handler.
+class CalibrationStore {
+
+    public:
+
+    CalibrationStore(const std::string& dir, const std::string& name, const cv::Size& boardSize);
+    ~CalibrationStore();
+
+    // Ajoute un couple d'images (les buffers sont repris) et retourne son identifiant
+    int add(cv::Mat frames[STEREO_CAMERAS]);
+
+    // Attend la fin des écritures en cours
+    void flush();
+
+    // Efface toutes les images et le manifeste
+    void clear();
+
+    // Couples écrits, dans l'ordre d'ajout
+    std::vector<CalibrationPair> getPairs();
+    int size();
+
+    // Recherche et affinage des coins de l'échiquier
+    static bool findCorners(const cv::Mat& gray, const cv::Size& boardSize, std::vector<cv::Point2f>& corners);
+
+    private:
+
+    struct PendingPair {
+        CalibrationPair pair;
+        cv::Mat frames[STEREO_CAMERAS];
+    };
+
+    void writerThread();
+    void detect(CalibrationPair& pair, const cv::Mat frames[STEREO_CAMERAS]);
+    void loadManifest();
+    void importLegacyImages();
+    bool saveManifest(const std::vector<CalibrationPair>& pairs, int nextId);
+
+    std::string dir;
+    std::string manifestFile;
+    cv::Size boardSize;
+
+    // mutex protège l'état en mémoire et n'est jamais tenu pendant une écriture sur
+    // disque : add() rend la main tout de suite. fileMutex sérialise les accès au
+    // dossier (images, manifeste, effacement) ; il est pris avant mutex.
+    std::mutex mutex;
+    std::mutex fileMutex;
+    std::condition_variable queueCond;
+    std::condition_variable idleCond;
+    std::deque<PendingPair> queue;
+    std::vector<CalibrationPair> pairs;
+    int nextId;
+    int generation;  // Incrémenté par clear : les écritures en cours sont abandonnées
+    bool writing;
+    bool running;
+    std::thread writer;
+};
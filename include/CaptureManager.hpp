@@ -0,0 +1,103 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Configuration d'une caméra
+struct CameraConfig {
+    std::string name;
+    int device;
+    int width;
+    int height;
+    int fps;
+    std::string source = "device";  // "device", "synthetic" (mire générée) ou "replay" (enregistrement)
+    std::string file;               // Enregistrement relu par "replay"
+    int stream = 0;                 // Flux de l'enregistrement (0 gauche, 1 droite)
+};
+
+// Paire stéréo : deux caméras avec leur propre calibration et leur propre disparité
+struct StereoPairConfig {
+    std::string name;
+    int left;             // Indice de la caméra gauche dans la liste des caméras
+    int right;            // Indice de la caméra droite
+    std::string dataDir;  // Dossier des images et de la calibration de la paire
+    bool sharedMemory = false;  // Export des images et de la disparité en mémoire partagée
+    double obstacleMaxDistance = 8.0;  // Portée de la carte d'obstacles (mètres)
+    double obstacleMinHeight = -1e9;   // Bande de hauteur des obstacles (Y vers le bas, mètres),
+    double obstacleMaxHeight = 1e9;    // sans filtre par défaut
+};
+
+// Configuration de la capture, lue au démarrage
+struct CaptureConfig {
+    std::vector<CameraConfig> cameras;
+    std::vector<StereoPairConfig> pairs;
+
+    // Lecture du fichier YAML, ou configuration par défaut s'il est absent
+    static CaptureConfig load(const std::string& filename);
+
+    // Deux caméras (/dev/video0 et /dev/video2) en une paire "stereo" dans ./data
+    static CaptureConfig defaults();
+};
+
+// Identité d'une image capturée, transmise à chaque étape jusqu'au client
+struct FrameInfo {
+    uint64_t seq = 0;        // Numéro de l'image, par caméra
+    int64_t timestamp = 0;   // Heure de capture en microsecondes (horloge murale)
+};
+
+// Appelé par le thread de capture à chaque nouvelle image : il ne doit jamais bloquer
+typedef std::function<void(int camID, uint64_t seq, int64_t timestamp, const cv::Mat& frame)> FrameObserver;
+
+// Gestionnaire de capture : un thread par caméra, le nombre de caméras
+// est connu à l'exécution
+class CaptureManager {
+
+    public:
+
+    CaptureManager(const CaptureConfig& config);
+    ~CaptureManager();
+
+    // Getters
+    int getNbCameras() const;
+    const CameraConfig& getCamera(int id) const;
+    const std::vector<StereoPairConfig>& getPairs() const;
+    // Copie de l'image courante ; info reçoit son numéro et son heure de capture
+    bool copyFrameById(int id, cv::Mat& frame, FrameInfo* info = nullptr);
+
+    // Description des caméras et des paires au format JSON
+    std::string toJson() const;
+
+    // Abonnement aux nouvelles images de toutes les caméras (enregistrement...)
+    int addFrameObserver(const FrameObserver& observer);
+    void removeFrameObserver(int handle);
+
+    private:
+
+    // Thread de capture d'une caméra
+    void captureThread(int camID);
+
+    struct Camera {
+        CameraConfig config;
+        std::mutex frameMutex;
+        cv::Mat frame;
+        uint64_t seq = 0;
+        int64_t timestamp = 0;  // Heure de capture en microsecondes (horloge murale)
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Camera>> cameras;
+    std::vector<StereoPairConfig> pairs;
+    bool running;
+
+    std::mutex observersMutex;
+    std::map<int, FrameObserver> observers;
+    int nextObserver = 0;
+};
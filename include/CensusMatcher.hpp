@@ -0,0 +1,44 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Appariement stéréo par transformée de census 5x5 et distance de Hamming.
+// Moins sensible que StereoBM (SAD) aux écarts de luminosité entre les deux
+// caméras. Les noyaux utilisent les intrinsèques universelles d'OpenCV
+// (NEON sur le Pi, SSE/AVX sur x86) et les lignes sont traitées en parallèle.
+class CensusMatcher {
+
+    public:
+
+    CensusMatcher(int numDisparities = 16, int windowSize = 9);
+
+    // Disparité au format StereoBM : CV_16S, valeurs multipliées par 16,
+    // -16 pour les pixels invalides
+    void compute(const cv::Mat& left, const cv::Mat& right, cv::Mat& disparity);
+
+    // Implémentation scalaire de référence, pour valider la version vectorisée
+    void computeReference(const cv::Mat& left, const cv::Mat& right, cv::Mat& disparity) const;
+
+    int getNumDisparities() const;
+    int getWindowSize() const;
+
+    // Voisinage 5x5 : 24 bits rangés dans 3 plans de 8 bits
+    static const int CENSUS_RADIUS = 2;
+    static const int CENSUS_PLANES = 3;
+    static const int CENSUS_BITS = 24;
+
+    private:
+
+    static void censusTransform(const cv::Mat& src, cv::Mat planes[CENSUS_PLANES]);
+    void matchStripe(int stripe, int nbStripes, cv::Mat& disparity);
+
+    int numDisparities;
+    int windowSize;
+
+    // Buffers conservés d'une image à l'autre
+    cv::Mat leftCensus[CENSUS_PLANES];
+    cv::Mat rightCensus[CENSUS_PLANES];
+    std::vector<cv::Mat> costBuffers;
+    std::vector<cv::Mat> rowBuffers;
+};
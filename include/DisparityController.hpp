@@ -5,32 +5,144 @@
 #include <thread>
 #include <iostream>
 #include <filesystem>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
 
-#include "IndexController.hpp"
+#include "CaptureManager.hpp"
 #include "commons.hpp"
+#include "StreamDemand.hpp"
+#include "FramePool.hpp"
+#include "CensusMatcher.hpp"
+#include "RectificationContext.hpp"
+#include "StaticResources.hpp"
+#include "TaskScheduler.hpp"
+#include "SpscQueue.hpp"
+#include "StereoRecorder.hpp"
+#include "SharedFrameExport.hpp"
+#include "ObstacleMap.hpp"
+#include "FrameTracer.hpp"
+#include "EncodeService.hpp"
 
+namespace fs = std::filesystem;
+
+// Moteurs de calcul de la disparité
+enum DisparityEngine {
+    ENGINE_BM = 0,     // cv::StereoBM (SAD)
+    ENGINE_CENSUS = 1  // CensusMatcher (census + Hamming)
+};
+
+// Image en cours de traitement dans le pipeline de disparité. Un nombre fixe
+// de ces jobs circule entre les étages, leurs buffers sont donc réutilisés.
+struct DisparityJob {
+    FrameInfo frame;                                       // Image gauche capturée (numéro, heure)
+    std::chrono::steady_clock::time_point start;           // Début de la rectification
+    bool dropped;                                          // Image périmée, à recycler sans traitement
+    std::shared_ptr<const RectificationContext> ctx;
+    cv::Mat rectified1, rectified2, disparity16, disparity8;
+};
+
+// Statistiques d'un étage du pipeline
+struct PipelineStageStats {
+    std::atomic<long> frames{0};
+    std::atomic<long> dropped{0};
+    std::atomic<long> lastMicros{0};
+    std::atomic<long> avgMicros{0};  // Moyenne glissante
+
+    void record(long micros);
+};
+
+// Étages du pipeline de disparité
+enum PipelineStage {
+    PIPELINE_RECTIFY = 0,  // Copie des images, niveaux de gris, rectification
+    PIPELINE_MATCH,        // Mise en correspondance (StereoBM ou census)
+    PIPELINE_OBSTACLES,    // Profil d'obstacles et grille d'occupation
+    PIPELINE_PUBLISH,      // Normalisation 8 bits et publication
+    NB_PIPELINE_STAGES
+};
+
+// Calcul et diffusion de la disparité d'une paire stéréo
 class DisparityController {
     public:
-    DisparityController(struct mg_context* ctx, IndexController* indexCtrl);
+    DisparityController(struct mg_context* ctx, CaptureManager* captureManager,
+                        const StereoPairConfig& pair, bool legacyRoutes);
     ~DisparityController();
 
-    // Threads de caméra
-    void static disparityThread();
+    // Fin des handlers en cours, avant mg_stop ; le destructeur vient après
+    void stop();
+
+    // Threads de calcul : rectification de l'image N+1, correspondance de
+    // l'image N, obstacles et publication des images précédentes se recouvrent
+    void rectifyStage();
+    void matchStage();
+    void obstacleStage();
+    void publishStage();
+    void calibrationReloadThread();
+
+    // Rechargement de la calibration sans redémarrer le service
+    void requestCalibrationReload();
 
     // Handlers
     static int streamHandler(struct mg_connection *conn, void *param);
     static int rootHandler(struct mg_connection *conn, void *param);
+    static int engineHandler(struct mg_connection *conn, void *param);
+    static int benchmarkHandler(struct mg_connection *conn, void *param);
+    static int pipelineHandler(struct mg_connection *conn, void *param);
+    static int recordingHandler(struct mg_connection *conn, void *param);
+    static int obstaclesHandler(struct mg_connection *conn, void *param);
 
     private:
 
-    static void loadCalibration(const std::string& filename,
-                     cv::Mat& cameraMatrix1, cv::Mat& distCoeffs1,
-                     cv::Mat& cameraMatrix2, cv::Mat& distCoeffs2,
-                     cv::Mat& R, cv::Mat& T);
-
-    static bool running;
-    static IndexController* indexCtrl;
-    static std::mutex disparityMutex;
-    static std::thread disThread;
-    static cv::Mat disparity;
-};
\ No newline at end of file
+    std::shared_ptr<const RectificationContext> getRectification();
+    void forward(SpscQueue<DisparityJob*>& queue, PipelineStage stage, DisparityJob* job);
+    bool nextJob(SpscQueue<DisparityJob*>& queue, PipelineStage stage, DisparityJob*& job);
+
+    StereoPairConfig pair;
+    cv::Size imageSize;
+    bool running;
+    CaptureManager* captureManager;
+    std::mutex disparityMutex;
+    std::thread stageThreads[NB_PIPELINE_STAGES];
+    cv::Mat disparity;
+    FrameInfo disparityInfo;  // Image d'origine de la disparité publiée
+    StreamDemand disparityDemand;
+    int encodeStream;         // Flux MJPEG de la disparité dans le service d'encodage
+    std::atomic<int> engine;
+    std::shared_ptr<const RectificationContext> rectification;
+    std::thread reloadThread;
+    std::mutex reloadMutex;
+    std::condition_variable reloadCond;
+    bool reloadRequested;
+    std::string calibrationFile;
+    std::string calibrationBundle;
+
+    // Pipeline : les jobs libres reviennent de la publication vers la rectification
+    std::vector<std::unique_ptr<DisparityJob>> jobs;
+    SpscQueue<DisparityJob*> freeJobs;
+    SpscQueue<DisparityJob*> rectifiedJobs;
+    SpscQueue<DisparityJob*> matchedJobs;
+    SpscQueue<DisparityJob*> measuredJobs;
+    QueueSignal stageSignals[NB_PIPELINE_STAGES];  // Réveil de chaque étage (job en entrée, arrêt)
+    std::atomic<bool> newFrames;                   // Nouvelle image d'une caméra de la paire
+    int frameObserver;
+    PipelineStageStats stageStats[NB_PIPELINE_STAGES];
+    std::atomic<long> latencyMicros;  // Copie des images -> publication, moyenne glissante
+
+    // Dernier résumé des obstacles, déjà en JSON : les clients attendent un numéro plus récent
+    StreamDemand obstaclesDemand;
+    std::mutex obstaclesMutex;
+    std::condition_variable obstaclesCond;
+    std::string obstaclesJson;
+    uint64_t obstaclesSeq;
+
+    // Enregistrement des images de la paire (et de la disparité)
+    std::unique_ptr<StereoRecorder> recorder;
+
+    // Export en mémoire partagée (sharedMemory dans la configuration de la paire) ;
+    // les lecteurs ne sont pas visibles du service : la disparité est alors calculée en continu
+    std::unique_ptr<SharedFrameExport> sharedExport;
+    std::unique_ptr<StreamDemand::Subscription> sharedSubscription;
+};
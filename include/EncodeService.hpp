@@ -0,0 +1,109 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CaptureManager.hpp"
+#include "JpegEncoder.hpp"
+
+// Image encodée en JPEG, partagée entre tous les clients d'un flux
+struct EncodedFrame {
+    uint64_t seq = 0;
+    int64_t timestamp = 0;
+    JpegBuffer data;
+};
+
+// Service d'encodage JPEG des flux MJPEG : chaque nouvelle image d'un flux est
+// encodée une seule fois, par un petit pool de threads (classe encode), quel
+// que soit le nombre de clients. Les producteurs signalent leurs nouvelles
+// images avec notify() ; les threads dorment sinon. Les flux sont traités en
+// parallèle ; chaque thread garde son encodeur et ses buffers, et les sorties
+// sont recyclées une fois que plus aucun client ne les envoie. Un flux sans
+// client n'est pas encodé.
+class EncodeService {
+
+    public:
+
+    // Copie de la dernière image de la source ; false si elle n'en a pas encore
+    typedef std::function<bool(cv::Mat& frame, FrameInfo& info)> CopyFunction;
+
+    static EncodeService& instance();
+
+    void start(int nbWorkers);
+    void stop();
+
+    // Déclare un flux, retourne son identifiant
+    int addStream(const std::string& name, const CopyFunction& copy, int quality = 95);
+
+    // Au retour, plus aucun thread d'encodage n'appelle la fonction de copie du flux
+    void removeStream(int id);
+
+    // Nouvelle image disponible pour le flux (appelé par le producteur, après publication)
+    void notify(int id);
+
+    // Image encodée plus récente que afterSeq, nullptr après timeoutMs
+    std::shared_ptr<const EncodedFrame> waitForFrame(int id, uint64_t afterSeq, int timeoutMs);
+
+    // Etat des flux (clients, images encodées, temps d'encodage) au format JSON
+    std::string statusJson();
+
+    // Client d'un flux, pour la durée d'un handler
+    class Subscription {
+        public:
+        Subscription(int id) : id(id) { instance().subscribe(id, 1); }
+        ~Subscription() { instance().subscribe(id, -1); }
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+        private:
+        int id;
+    };
+
+    private:
+
+    EncodeService();
+
+    // Etat protégé par le mutex du service, sauf les statistiques
+    struct Stream {
+        std::string name;
+        CopyFunction copy;
+        int quality;
+        const char* trace;
+
+        int clients = 0;
+        bool dirty = false;       // Image plus récente que la dernière encodée
+        bool busy = false;        // Un seul thread encode le flux à la fois
+        int generation = 0;       // Incrémenté quand le dernier client part
+        uint64_t encodedSeq = 0;
+
+        // Sorties recyclées ; latest est la dernière image envoyée aux clients
+        std::vector<std::shared_ptr<EncodedFrame>> buffers;
+        std::shared_ptr<const EncodedFrame> latest;
+
+        std::atomic<long> frames{0};
+        std::atomic<long> lastMicros{0};
+        std::atomic<long> avgMicros{0};
+        std::atomic<long> bytes{0};
+    };
+
+    void subscribe(int id, int delta);
+    void worker();
+    void encode(Stream& stream, int id, std::map<int, cv::Mat>& frames, JpegEncoder& encoder);
+    std::shared_ptr<EncodedFrame> acquireBuffer(Stream& stream);
+
+    std::mutex mutex;
+    std::condition_variable workCond;   // Flux à encoder, ou arrêt
+    std::condition_variable frameCond;  // Image encodée ou flux libéré
+    std::map<int, std::shared_ptr<Stream>> streams;
+    int nextStream;
+    std::vector<std::thread> workers;
+    bool running;
+};
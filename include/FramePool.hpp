@@ -0,0 +1,92 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Comptage des allocations de buffers cv::Mat, par image et par étape.
+// Les étapes gardent leurs buffers de travail d'une image à l'autre et
+// n'allouent qu'au démarrage ou lors d'un changement de résolution.
+// install() remplace l'allocateur par défaut d'OpenCV : toutes les allocations
+// réelles sont comptées, y compris celles faites dans cvtColor, remap, StereoBM...
+class FramePool {
+
+    public:
+
+    // Compteur de l'image en cours d'une étape
+    typedef std::atomic<long> Counter;
+
+    // Active le comptage, une fois au démarrage
+    static void install();
+
+    // Garantit qu'un buffer de travail a la bonne taille (n'alloue que si elle change)
+    static void ensure(cv::Mat& mat, const cv::Size& size, int type);
+
+    // Comptage des allocations par image et par étape : les allocations du
+    // thread entre beginFrame() et endFrame() sont attribuées à l'étape. Après
+    // warmupFrames images, toute allocation est anormale : elle est comptée à part
+    // dans /pool et signalée une fois par étape
+    static void beginFrame();
+    static long endFrame(const std::string& stage, long warmupFrames = 0);
+
+    // Image d'une étape, terminée sur tous les chemins de sortie du bloc
+    class Frame {
+        public:
+        Frame(const std::string& stage, long warmupFrames = 0);
+        ~Frame();
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        private:
+        const std::string& stage;
+        long warmupFrames;
+    };
+
+    // Compteur de l'image en cours sur ce thread (nullptr hors image)
+    static Counter* currentCounter();
+
+    // Rattache un thread qui travaille pour une image (pool de calcul,
+    // cv::parallel_for_) au compteur de cette image, pour la durée d'un bloc
+    class Scope {
+        public:
+        Scope(Counter* counter);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        private:
+        Counter* previous;
+    };
+
+    // Appelé par l'allocateur à chaque allocation réelle
+    static void countAllocation();
+
+    // Allocations faites hors de toute image
+    static long unattributedAllocations();
+
+    // Statistiques au format JSON
+    static std::string statsJson();
+
+    private:
+
+    FramePool() = default;
+
+    static FramePool& instance();
+
+    struct StageStats {
+        long frames = 0;
+        long allocations = 0;
+        long lastFrameAllocations = 0;
+        long steadyAllocations = 0;  // Après la mise en route
+    };
+
+    std::mutex mutex;
+    std::map<std::string, StageStats> stages;
+
+    static std::atomic<long> allocations;
+    static std::atomic<long> unattributed;  // Hors de toute image (initialisation, threads non rattachés)
+    static thread_local Counter threadCounter;
+    static thread_local Counter* frameCounter;
+};
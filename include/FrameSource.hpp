@@ -0,0 +1,28 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include "CaptureManager.hpp"
+
+// Rôle d'une caméra dans sa paire stéréo (une caméra hors paire est à gauche)
+enum CameraRole {
+    CAMERA_LEFT = 0,
+    CAMERA_RIGHT = 1
+};
+
+// Origine des images d'une caméra : périphérique V4L2, mire générée ou
+// enregistrement relu. Les deux dernières permettent de faire tourner toute la
+// chaîne (et les mesures de débit) sans matériel.
+class FrameSource {
+
+    public:
+
+    virtual ~FrameSource() = default;
+
+    // Bloque jusqu'à l'image suivante ; false si aucune image n'est disponible
+    virtual bool read(cv::Mat& frame) = 0;
+
+    // Source décrite par la configuration, nullptr si elle ne peut pas être ouverte.
+    // La mire de la caméra droite est décalée de celle de la gauche (disparité synthétique).
+    static std::unique_ptr<FrameSource> create(const CameraConfig& config, CameraRole role);
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Traces par image : chaque étape enregistre un intervalle (nom, numéro de
+// l'image, début, durée, thread) dans un anneau sans verrou de taille fixe.
+// L'écriture coûte un fetch_add et quelques écritures : elle reste active en
+// permanence. L'export suit le format "trace event" de Chrome (chrome://tracing,
+// Perfetto).
+class FrameTracer {
+
+    public:
+
+    static FrameTracer& instance();
+
+    // Nom d'étape à durée de vie illimitée, à obtenir une fois à l'initialisation
+    static const char* intern(const std::string& name);
+
+    // Horloge des traces (monotone, microsecondes)
+    static int64_t now();
+
+    void record(const char* name, uint64_t seq, int64_t start, int64_t end);
+
+    // Intervalles des dernières secondes, au format JSON de Chrome
+    std::string chromeTraceJson(double seconds);
+
+    // Intervalle couvrant la durée de vie de l'objet
+    class Span {
+        public:
+        Span(const char* name, uint64_t seq) : name(name), seq(seq), start(now()) {}
+        ~Span() { instance().record(name, seq, start, now()); }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        // Le numéro de l'image n'est parfois connu qu'après le début de l'étape
+        void setSeq(uint64_t seq) { this->seq = seq; }
+
+        private:
+        const char* name;
+        uint64_t seq;
+        int64_t start;
+    };
+
+    private:
+
+    FrameTracer();
+
+    static const size_t CAPACITY = 1 << 16;  // Puissance de deux
+
+    // Un intervalle ; stamp vaut 2 * index + 1 pendant l'écriture, 2 * index + 2 ensuite
+    // (les champs sont atomiques pour que la lecture concurrente reste définie)
+    struct Event {
+        std::atomic<uint64_t> stamp;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> seq;
+        std::atomic<int64_t> start;
+        std::atomic<int64_t> duration;
+        std::atomic<int> tid;
+    };
+
+    std::unique_ptr<Event[]> events;
+    std::atomic<uint64_t> next;
+};
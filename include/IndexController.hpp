@@ -6,35 +6,50 @@
 #include <iostream>
 #include <regex>
 #include <filesystem>
+#include <cstring>
 
 #include "commons.hpp"
+#include "StreamDemand.hpp"
+#include "FramePool.hpp"
+#include "CaptureManager.hpp"
+#include "StaticResources.hpp"
+#include "TaskScheduler.hpp"
+#include "FrameTracer.hpp"
+#include "EncodeService.hpp"
 
 namespace fs = std::filesystem;
 
 class IndexController {
 
     public:
-    IndexController(struct mg_context* ctx);
+    IndexController(struct mg_context* ctx, CaptureManager* captureManager);
     ~IndexController();
 
-    // Threads de caméra
-    void static captureThread(int camID);
+    // Fin des handlers en cours, avant mg_stop ; le destructeur vient après
+    void stop();
 
     // Handlers
     static int streamHandler(struct mg_connection *conn, void *param);
     static int rootHandler(struct mg_connection *conn, void *param);
-
-    // Getter
-    cv::Mat getFrameById(int id);
+    static int camerasHandler(struct mg_connection *conn, void *param);
+    static int stagesHandler(struct mg_connection *conn, void *param);
+    static int poolHandler(struct mg_connection *conn, void *param);
+    static int threadsHandler(struct mg_connection *conn, void *param);
+    static int traceHandler(struct mg_connection *conn, void *param);
+    static int encodersHandler(struct mg_connection *conn, void *param);
 
     private:
 
-    std::thread capThread1;
-    std::thread capThread2;
-
-    static std::mutex frameMutexes[NB_WEBCAMS];
-    static cv::Mat frames[NB_WEBCAMS];
-    static int cameraDevice[NB_WEBCAMS];
-    static int cameraID[NB_WEBCAMS];
-    static bool running;
+    // Paramètre des handlers de flux : une caméra
+    struct StreamParam {
+        IndexController* ctrl;
+        int camID;
+        int encodeID;  // Flux du service d'encodage
+    };
+
+    CaptureManager* captureManager;
+    std::vector<StreamParam> streamParams;
+    std::vector<std::string> streamRoutes;
+    int encodeObserver;  // Nouvelles images des caméras -> service d'encodage
+    bool running;
 };
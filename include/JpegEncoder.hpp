@@ -0,0 +1,72 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <csetjmp>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <jpeglib.h>
+
+// Sortie d'un encodeur : buffer brut conservé d'une image à l'autre, agrandi
+// au besoin mais jamais remis à zéro (contrairement à std::vector::resize)
+class JpegBuffer {
+
+    public:
+
+    const uchar* data() const { return bytes.get(); }
+    size_t size() const { return used; }
+
+    private:
+
+    friend class JpegEncoder;
+
+    std::unique_ptr<uchar[]> bytes;
+    size_t capacity = 0;
+    size_t used = 0;
+};
+
+// Encodeur JPEG réutilisable (libjpeg-turbo) : le contexte de compression et
+// ses tables sont créés une fois, et les paramètres ne sont recalculés que si
+// la taille, le format ou la qualité changent. La sortie est écrite directement
+// dans le buffer fourni.
+// Les images 8 bits à un canal (échiquier, disparité) sont encodées en
+// niveaux de gris sans conversion ; les images BGR sont lues telles quelles.
+// Un encodeur n'est utilisé que par un thread à la fois.
+class JpegEncoder {
+
+    public:
+
+    JpegEncoder();
+    ~JpegEncoder();
+
+    JpegEncoder(const JpegEncoder&) = delete;
+    JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+    // CV_8UC1 ou CV_8UC3 (BGR) ; les autres types passent par cv::imencode
+    bool encode(const cv::Mat& image, int quality, JpegBuffer& out);
+
+    private:
+
+    // Erreur de libjpeg : retour à encode() au lieu de quitter le programme
+    struct ErrorManager {
+        jpeg_error_mgr pub;
+        jmp_buf jump;
+    };
+
+    static void errorExit(j_common_ptr cinfo);
+    static void initDestination(j_compress_ptr cinfo);
+    static boolean emptyOutputBuffer(j_compress_ptr cinfo);
+    static void termDestination(j_compress_ptr cinfo);
+    static void reserve(JpegBuffer& out, size_t capacity, size_t keep);
+
+    jpeg_compress_struct cinfo;
+    ErrorManager error;
+    jpeg_destination_mgr destination;
+    JpegBuffer* output;
+    std::vector<uchar> rowBuffer;  // Conversion BGR -> RGB sans l'extension JCS_EXT_BGR
+    std::vector<uchar> fallback;   // Sortie de cv::imencode (autres types)
+
+    // Paramètres de la dernière image (qualité -1 : à recalculer)
+    int lastComponents;
+    int lastQuality;
+};
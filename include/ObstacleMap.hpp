@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Résumé des obstacles d'une image de disparité, quelques centaines d'octets
+struct ObstacleSummary {
+    uint64_t seq = 0;               // Image gauche d'origine
+    int64_t timestamp = 0;          // Heure de capture, microsecondes depuis l'epoch
+    std::vector<uint16_t> columns;  // Obstacle le plus proche par bande verticale (mm, 0 : rien)
+    std::vector<uint8_t> grid;      // Occupation vue de dessus, 1 bit par cellule
+    int nearestColumn = -1;         // Bande de l'obstacle le plus proche, -1 si aucun
+    uint16_t nearest = 0;           // Distance de l'obstacle le plus proche (mm)
+};
+
+// Projection des disparités valides par Q (repère de la caméra gauche rectifiée :
+// X à droite, Y vers le bas, Z devant) en deux vues compactes :
+//  - profil par colonnes : distance du plus proche obstacle dans chaque bande
+//    verticale de l'image (gauche à droite) ;
+//  - grille d'occupation de GRID_SIZE x GRID_SIZE cellules, X dans
+//    [-maxDistance / 2, maxDistance / 2], Z dans [0, maxDistance], lignes de la
+//    plus proche à la plus lointaine.
+// Il faut MIN_POINTS points pour marquer une bande ou une cellule : les faux
+// appariements isolés ne créent pas d'obstacle.
+class ObstacleMap {
+
+    public:
+
+    static const int COLUMNS = 64;
+    static const int GRID_SIZE = 32;
+    static const int MIN_POINTS = 4;
+    static const int STEP = 2;  // Un pixel sur STEP dans chaque direction
+
+    // Bande de hauteur retenue (Y, mètres), pour ignorer le sol ou le plafond
+    ObstacleMap(double maxDistance, double minHeight, double maxHeight);
+
+    // disparity16 : CV_16S x16 (StereoBM ou census), Q : matrice de reprojection
+    void compute(const cv::Mat& disparity16, const cv::Mat& Q, ObstacleSummary& summary);
+
+    std::string toJson(const ObstacleSummary& summary) const;
+
+    private:
+
+    double maxDistance;
+    double minHeight;
+    double maxHeight;
+
+    // Buffers conservés d'une image à l'autre
+    std::vector<std::vector<float>> columnDepths;
+    std::vector<uint16_t> cellCounts;
+    std::vector<double> xNumerators;
+};
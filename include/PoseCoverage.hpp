@@ -0,0 +1,53 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// Pose de l'échiquier dans l'image, mesurée sur ses quatre coins extérieurs
+struct BoardPose {
+    float x, y;    // Centre, normalisé dans [0, 1]
+    float scale;   // Racine de la surface occupée rapportée à celle de l'image
+    float tiltX;   // Inclinaison autour de l'axe vertical (bords gauche / droit)
+    float tiltY;   // Inclinaison autour de l'axe horizontal (bords haut / bas)
+
+    // Plus grand écart entre deux poses, pour juger si l'échiquier est immobile
+    float distance(const BoardPose& other) const;
+};
+
+// Couverture des poses déjà enregistrées : position sur une grille 3x3,
+// trois tailles et cinq inclinaisons (de face, gauche, droite, haut, bas).
+// Une nouvelle pose n'est utile que si elle remplit une case encore vide.
+class PoseCoverage {
+
+    public:
+
+    static const int POSITION_BINS = 3;  // Par axe
+    static const int SCALE_BINS = 3;
+    static const int TILT_BINS = 5;
+
+    PoseCoverage();
+
+    static BoardPose measure(const std::vector<cv::Point2f>& corners, const cv::Size& boardSize,
+                             const cv::Size& imageSize);
+
+    // La pose remplit-elle au moins une case vide ?
+    bool adds(const BoardPose& pose) const;
+    void add(const BoardPose& pose);
+
+    // Toutes les cases sont remplies
+    bool complete() const;
+    void clear();
+
+    std::string toJson() const;
+
+    private:
+
+    static int positionBin(const BoardPose& pose);
+    static int scaleBin(const BoardPose& pose);
+    static int tiltBin(const BoardPose& pose);
+
+    bool positions[POSITION_BINS * POSITION_BINS];
+    bool scales[SCALE_BINS];
+    bool tilts[TILT_BINS];
+};
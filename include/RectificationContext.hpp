@@ -0,0 +1,60 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+
+// Contexte de rectification d'une paire stéréo (maps, Q, ROIs).
+// Il est immuable une fois construit : un nouveau contexte est créé à chaque
+// recalibration puis échangé atomiquement entre deux images.
+class RectificationContext {
+
+    public:
+
+    // Version du format binaire, à incrémenter à chaque changement de structure
+    static const uint32_t BUNDLE_VERSION = 1;
+
+    // Calcul complet à partir des paramètres intrinsèques et extrinsèques
+    static std::shared_ptr<const RectificationContext> fromCalibration(
+                     const cv::Mat& cameraMatrix1, const cv::Mat& distCoeffs1,
+                     const cv::Mat& cameraMatrix2, const cv::Mat& distCoeffs2,
+                     const cv::Mat& R, const cv::Mat& T, const cv::Size& imageSize);
+
+    // Lecture du fichier YAML (avec calcul des maps)
+    // Retourne nullptr si le fichier est absent ou incomplet
+    static std::shared_ptr<const RectificationContext> fromFile(const std::string& filename,
+                                                               const cv::Size& imageSize);
+
+    // Lecture du bundle binaire, projeté en mémoire sans aucune analyse ni calcul
+    // Retourne nullptr si le fichier est absent, d'une autre version ou d'une autre taille d'image
+    static std::shared_ptr<const RectificationContext> fromBundle(const std::string& filename,
+                                                                 const cv::Size& imageSize);
+
+    // Ecriture du bundle binaire (fichier temporaire puis renommage)
+    bool saveBundle(const std::string& filename) const;
+
+    cv::Size imageSize;
+
+    // Calibration
+    cv::Mat cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T;
+
+    // Rectification
+    cv::Mat R1, R2, P1, P2, Q;
+    cv::Rect roi1, roi2;
+
+    // Maps en virgule fixe (CV_16SC2 + CV_16UC1), plus compactes et plus
+    // rapides à appliquer que les maps flottantes
+    cv::Mat map1xy, map1frac, map2xy, map2frac;
+
+    private:
+
+    RectificationContext() = default;
+
+    static bool loadCalibration(const std::string& filename,
+                     cv::Mat& cameraMatrix1, cv::Mat& distCoeffs1,
+                     cv::Mat& cameraMatrix2, cv::Mat& distCoeffs2,
+                     cv::Mat& R, cv::Mat& T);
+
+    // Projection mémoire du bundle, libérée avec le dernier contexte qui l'utilise
+    std::shared_ptr<void> mapping;
+};
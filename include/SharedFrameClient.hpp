@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SharedFrameRing.hpp"
+
+// Image lue dans un anneau en mémoire partagée. data pointe dans le segment :
+// rien n'est copié, l'image reste valide tant que isValid() le confirme.
+struct SharedFrame {
+    uint64_t seq = 0;
+    int64_t timestamp = 0;  // Heure de capture, microsecondes depuis l'epoch
+    int width = 0;
+    int height = 0;
+    int type = 0;           // Type cv::Mat : cv::Mat(height, width, type, (void*)data, step)
+    int step = 0;
+    const void* data = nullptr;
+
+    const SharedSlotHeader* slot = nullptr;
+    uint64_t stamp = 0;
+};
+
+// Bibliothèque cliente pour les processus de la même machine (sans dépendance
+// à OpenCV ni au serveur) : dernière image gauche, droite ou disparité 16 bits
+// d'une paire, sans encodage, sans socket et sans décodage.
+//
+//   SharedFrameClient client;
+//   client.open("stereo", "disparity");
+//   SharedFrame frame;
+//   while (client.waitForFrame(frame, 1000)) {
+//       cv::Mat disparity(frame.height, frame.width, frame.type, (void*)frame.data, frame.step);
+//       ... traitement ...
+//       if (!client.isValid(frame)) { ... image réécrite pendant le traitement ... }
+//   }
+class SharedFrameClient {
+
+    public:
+
+    SharedFrameClient() = default;
+    ~SharedFrameClient();
+
+    SharedFrameClient(const SharedFrameClient&) = delete;
+    SharedFrameClient& operator=(const SharedFrameClient&) = delete;
+
+    // stream : "left", "right" ou "disparity". false si le service ne publie pas ce flux.
+    bool open(const std::string& pair, const std::string& stream);
+    void close();
+    bool isOpen() const;
+
+    // Dernière image publiée, sans copie ; false si aucune image n'est encore publiée
+    bool latest(SharedFrame& frame) const;
+
+    // L'emplacement de l'image n'a pas été réécrit depuis latest()
+    bool isValid(const SharedFrame& frame) const;
+
+    // Copie cohérente de la dernière image dans buffer (frame.data pointe dans buffer)
+    bool copyLatest(SharedFrame& frame, std::vector<uint8_t>& buffer) const;
+
+    // Attend une image plus récente que la dernière rendue, au plus timeoutMs.
+    // Rattache le client si le service a redémarré entre-temps.
+    bool waitForFrame(SharedFrame& frame, int timeoutMs);
+
+    // Images publiées et images perdues (trop grandes) par le service
+    uint64_t getWrites() const;
+    uint64_t getDropped() const;
+
+    private:
+
+    bool replaced() const;
+
+    std::string pairName;
+    std::string streamName;
+    std::string name;
+    void* base = nullptr;
+    size_t size = 0;
+    const SharedRingHeader* header = nullptr;
+    unsigned long inode = 0;
+    uint64_t lastWrites = 0;
+};
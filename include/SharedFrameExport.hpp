@@ -0,0 +1,50 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "CaptureManager.hpp"
+#include "SharedFrameRing.hpp"
+#include "StereoRecorder.hpp"
+
+// Publication des dernières images brutes (gauche, droite) et de la disparité
+// 16 bits d'une paire dans des anneaux en mémoire partagée, pour les processus
+// de la même machine (voir SharedFrameClient). Chaque anneau n'a qu'un
+// écrivain : le thread de capture de la caméra, ou l'étage de publication de
+// la disparité. L'écriture est une copie, sans verrou ni attente du lecteur.
+class SharedFrameExport {
+
+    public:
+
+    SharedFrameExport(CaptureManager* captureManager, const StereoPairConfig& pair, int slotCount = 4);
+    ~SharedFrameExport();
+
+    // Appelé par l'étage de publication de la disparité (CV_16S, x16)
+    void pushDisparity(uint64_t seq, int64_t timestamp, const cv::Mat& disparity);
+
+    // Etat des anneaux au format JSON
+    std::string statusJson() const;
+
+    private:
+
+    // Segment d'un flux, créé à la première image (sa taille fixe celle des emplacements)
+    struct Ring {
+        std::string name;
+        void* base = nullptr;
+        size_t size = 0;
+        bool failed = false;                            // Pas de nouvel essai après une erreur
+        std::atomic<SharedRingHeader*> header{nullptr};  // Publié une fois le segment prêt
+    };
+
+    void push(int stream, uint64_t seq, int64_t timestamp, const cv::Mat& image);
+    bool create(Ring& ring, size_t frameBytes);
+
+    CaptureManager* captureManager;
+    StereoPairConfig pair;
+    int slotCount;
+    int observer;
+    Ring rings[NB_RECORD_STREAMS];
+};
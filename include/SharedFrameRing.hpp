@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Format des anneaux d'images en mémoire partagée POSIX (/dev/shm), commun au
+// service (écrivain) et à la bibliothèque cliente. Un segment par flux :
+//
+//   [SharedRingHeader][SharedSlotHeader][données]...[SharedSlotHeader][données]
+//
+// Chaque emplacement est protégé par un seqlock : stamp vaut 2 * n + 1 pendant
+// l'écriture de la n-ième image, 2 * n + 2 ensuite. Un lecteur vérifie stamp
+// avant et après la lecture ; l'écrivain ne bloque jamais. Une image reste
+// intacte pendant slotCount - 1 publications suivantes.
+// Sans dépendance à OpenCV : type est un type de cv::Mat (CV_8UC3, CV_16SC1...).
+
+static const char SHARED_RING_MAGIC[8] = {'P', 'V', 'S', 'H', 'M', 0, 0, 0};
+static const uint32_t SHARED_RING_VERSION = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomiques partagés entre processus");
+
+struct alignas(64) SharedRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint64_t slotSize;               // Octets de données par emplacement (multiple de 64)
+    uint64_t slotStride;             // En-tête + données
+    std::atomic<uint64_t> writes;    // Images publiées ; la dernière est dans (writes - 1) % slotCount
+    std::atomic<uint64_t> dropped;   // Images trop grandes pour un emplacement
+    std::atomic<int32_t> writerPid;
+};
+
+struct alignas(64) SharedSlotHeader {
+    std::atomic<uint64_t> stamp;
+    std::atomic<uint64_t> seq;       // Numéro de l'image (capture, ou image gauche pour la disparité)
+    std::atomic<int64_t> timestamp;  // Heure de capture, microsecondes depuis l'epoch
+    std::atomic<int32_t> width;
+    std::atomic<int32_t> height;
+    std::atomic<int32_t> type;
+    std::atomic<int32_t> step;       // Octets par ligne (lignes contiguës)
+};
+
+static_assert(sizeof(SharedRingHeader) == 64, "En-tête d'anneau sur 64 octets");
+static_assert(sizeof(SharedSlotHeader) == 64, "En-tête d'emplacement sur 64 octets");
+
+// Nom du segment d'un flux : /webcamstreamer.<paire>.<left|right|disparity>
+inline std::string sharedRingName(const std::string& pair, const std::string& stream) {
+    return "/webcamstreamer." + pair + "." + stream;
+}
+
+inline SharedSlotHeader* sharedSlot(void* base, const SharedRingHeader* header, uint64_t index) {
+    return (SharedSlotHeader*)((char*)base + sizeof(SharedRingHeader) + index * header->slotStride);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// File bornée sans verrou entre un seul producteur et un seul consommateur.
+// La capacité est arrondie à la puissance de deux supérieure ; push échoue
+// quand la file est pleine, pop quand elle est vide.
+template <typename T>
+class SpscQueue {
+    public:
+    explicit SpscQueue(size_t capacity) : head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        buffer.resize(size);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Côté producteur
+    bool push(const T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > mask) return false;
+        buffer[h & mask] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Côté consommateur
+    bool pop(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        item = buffer[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Nombre d'éléments en attente, approximatif si lu par un troisième thread
+    size_t size() const {
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t h = head.load(std::memory_order_acquire);
+        return h - t;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    private:
+    std::vector<T> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;  // Écrit par le producteur
+    alignas(64) std::atomic<size_t> tail;  // Écrit par le consommateur
+};
+
+// Réveil d'un consommateur qui dort en attendant une ou plusieurs SpscQueue.
+// Le producteur appelle notify() après push : tant que le consommateur a du
+// travail, rien n'est verrouillé ; le verrou n'est pris que s'il dort.
+class QueueSignal {
+    public:
+    QueueSignal() : sleeping(false) {}
+
+    QueueSignal(const QueueSignal&) = delete;
+    QueueSignal& operator=(const QueueSignal&) = delete;
+
+    // Côté producteur, après push
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) wakeAll();
+    }
+
+    // Réveil inconditionnel (arrêt)
+    void wakeAll() {
+        { std::lock_guard<std::mutex> lock(mutex); }
+        cond.notify_all();
+    }
+
+    // Côté consommateur : dort jusqu'à ce que ready() soit vrai (file non vide, arrêt...)
+    template <typename Predicate>
+    void wait(Predicate ready) {
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready()) cond.wait(lock);
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<bool> sleeping;  // Le consommateur dort ou va dormir
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <civetweb.h>
+#include <cstddef>
+#include <string>
+
+// Fichier de resources/ intégré à l'exécutable à la compilation
+struct EmbeddedResource {
+    const char* name;
+    const char* contentType;
+    const unsigned char* data;
+    size_t size;
+    const unsigned char* gzipData;  // nullptr si la compression n'apporte rien
+    size_t gzipSize;
+    const char* etag;               // Avec les guillemets, tel qu'envoyé
+    const char* gzipEtag;           // Celui de la variante gzip (suffixe -gz)
+};
+
+// Table générée par cmake/EmbedResources.cmake (terminée par une entrée vide)
+extern const EmbeddedResource EMBEDDED_RESOURCES[];
+extern const size_t NB_EMBEDDED_RESOURCES;
+
+// Envoi des pages statiques : ETag, 304 Not Modified, variante gzip si le
+// client l'accepte. Compilé avec RESOURCES_FROM_DISK, les fichiers sont relus
+// à chaque requête (développement des pages sans recompiler).
+class StaticResources {
+
+    public:
+
+    // Envoie resources/<name> et retourne le code HTTP
+    static int serve(struct mg_connection *conn, const std::string& name);
+
+    private:
+
+    static const EmbeddedResource* find(const std::string& name);
+    static bool acceptsGzip(struct mg_connection *conn);
+    static std::string trim(const std::string& text);
+    static int serveFromDisk(struct mg_connection *conn, const std::string& name);
+};
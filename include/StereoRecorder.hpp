@@ -0,0 +1,137 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CaptureManager.hpp"
+#include "SpscQueue.hpp"
+
+// Flux enregistrés pour une paire stéréo
+enum RecordStream {
+    RECORD_LEFT = 0,
+    RECORD_RIGHT,
+    RECORD_DISPARITY,  // Disparité brute CV_16S (x16)
+    NB_RECORD_STREAMS
+};
+
+// Enregistrement d'une paire stéréo dans un conteneur unique, en ajout seul :
+// en-tête, images brutes (une par bloc, alignées sur 64 octets), puis index
+// séquence/horodatage écrit à l'arrêt. Les threads de capture ne font qu'une
+// copie dans un emplacement libre ; sans emplacement libre l'image est perdue
+// et comptée, la capture n'attend jamais le disque. Une erreur d'écriture
+// (disque plein...) arrête l'enregistrement et apparaît dans statusJson().
+class StereoRecorder {
+
+    public:
+
+    StereoRecorder(CaptureManager* captureManager, const StereoPairConfig& pair, int slotsPerStream = 8);
+    ~StereoRecorder();
+
+    // Démarre l'enregistrement dans filename (la disparité en option)
+    bool start(const std::string& filename, bool withDisparity);
+    void stop();
+    bool isRecording() const;
+
+    // Appelé par l'étage de publication de la disparité
+    void pushDisparity(uint64_t seq, int64_t timestamp, const cv::Mat& disparity);
+
+    // Etat de l'enregistrement au format JSON
+    std::string statusJson();
+
+    private:
+
+    struct Slot {
+        uint64_t seq;
+        int64_t timestamp;
+        cv::Mat image;
+    };
+
+    // Un producteur (capture ou disparité) et un consommateur (l'écrivain) par flux
+    struct Stream {
+        explicit Stream(int nbSlots);
+        std::vector<std::unique_ptr<Slot>> slots;
+        SpscQueue<Slot*> freeSlots;
+        SpscQueue<Slot*> pending;
+        std::atomic<long> written;
+        std::atomic<long> dropped;
+    };
+
+    void push(int stream, uint64_t seq, int64_t timestamp, const cv::Mat& image);
+    void writerThread();
+
+    CaptureManager* captureManager;
+    StereoPairConfig pair;
+    int observer;
+    std::unique_ptr<Stream> streams[NB_RECORD_STREAMS];
+
+    std::mutex controlMutex;  // start / stop
+    std::atomic<bool> recording;
+    std::atomic<bool> withDisparity;
+    std::string filename;
+    std::ofstream out;
+    std::atomic<uint64_t> bytesWritten;
+    std::thread writer;
+    QueueSignal writerSignal;     // Réveil de l'écrivain (image en attente, arrêt)
+    std::atomic<bool> failed;     // Erreur d'écriture : failure est alors fixé
+    std::string failure;
+};
+
+// Image lue dans un enregistrement ; image pointe dans le fichier projeté
+struct RecordedFrame {
+    int stream;
+    uint64_t seq;
+    int64_t timestamp;
+    cv::Mat image;
+};
+
+// Lecture d'un enregistrement projeté en mémoire, en accès direct.
+// Un fichier sans index (enregistrement interrompu) est relu bloc par bloc.
+class RecordingReader {
+
+    public:
+
+    // Retourne nullptr si le fichier est absent ou n'est pas un enregistrement
+    static std::shared_ptr<const RecordingReader> open(const std::string& filename);
+
+    const std::string& getPairName() const;
+    size_t size() const;
+
+    // Image numéro i dans l'ordre d'écriture, sans copie (lecture seule)
+    RecordedFrame frame(size_t i) const;
+
+    // Images d'un flux, dans l'ordre d'écriture (indices pour frame)
+    const std::vector<size_t>& streamFrames(int stream) const;
+
+    // Indice de l'image d'un flux avec ce numéro de séquence, -1 si absente
+    long findBySeq(int stream, uint64_t seq) const;
+
+    // Indice de la première image d'un flux prise à timestamp ou après, -1 si aucune
+    long findByTimestamp(int stream, int64_t timestamp) const;
+
+    private:
+
+    RecordingReader() = default;
+
+    struct Entry {
+        int stream;
+        int type;
+        int rows;
+        int cols;
+        uint64_t seq;
+        int64_t timestamp;
+        uint64_t offset;
+    };
+
+    std::string pairName;
+    std::vector<Entry> entries;
+    std::vector<size_t> byStream[NB_RECORD_STREAMS];
+    const uchar* bytes = nullptr;
+    std::shared_ptr<void> mapping;
+};
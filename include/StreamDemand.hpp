@@ -0,0 +1,61 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+
+// Compteur d'abonnés d'un flux dérivé (échiquier, disparité...).
+// L'étape qui produit le flux se met en veille tant que personne ne le regarde.
+class StreamDemand {
+
+    public:
+
+    StreamDemand(const std::string& name);
+    ~StreamDemand();
+
+    StreamDemand(const StreamDemand&) = delete;
+    StreamDemand& operator=(const StreamDemand&) = delete;
+
+    // Abonnement d'un client au flux
+    void subscribe();
+    void unsubscribe();
+
+    // Bloque l'étape tant qu'il n'y a aucun abonné (ou jusqu'à l'arrêt)
+    // Retourne true si l'étape doit travailler
+    bool waitForSubscribers(const bool& running);
+
+    // Version non bloquante, pour une étape qui sert plusieurs flux
+    bool poll();
+
+    // Getters
+    const std::string& getName() const;
+    int getSubscribers();
+    bool isActive();
+
+    // Etat de toutes les étapes au format JSON
+    static std::string statusJson();
+
+    // Abonnement limité à la durée de vie d'un handler
+    class Subscription {
+        public:
+        Subscription(StreamDemand& demand) : demand(demand) { demand.subscribe(); }
+        ~Subscription() { demand.unsubscribe(); }
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+        private:
+        StreamDemand& demand;
+    };
+
+    private:
+
+    static std::mutex& registryMutex();
+    static std::vector<StreamDemand*>& registry();
+
+    std::string name;
+    std::mutex mutex;
+    std::condition_variable cond;
+    int subscribers;
+    bool idle;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Classes d'étapes, chacune avec ses cœurs et sa priorité
+enum StageClass {
+    STAGE_CAPTURE = 0,  // Threads de capture, dédiés
+    STAGE_COMPUTE = 1,  // Rectification, appariement, détection d'échiquier
+    STAGE_ENCODE = 2,   // Encodage et envoi des flux
+    STAGE_SERVICE = 3,  // Tâches de fond (rechargement de la calibration...)
+    NB_STAGE_CLASSES = 4
+};
+
+// Placement d'une classe d'étapes
+struct StageClassConfig {
+    std::vector<int> cpus;  // Cœurs autorisés (vide : tous)
+    int nice;               // Priorité (nice Linux, négatif = plus prioritaire)
+};
+
+// Configuration de l'ordonnanceur, lue dans le même fichier que les caméras
+struct SchedulerConfig {
+    StageClassConfig classes[NB_STAGE_CLASSES];
+    int workers;  // Nombre de threads du pool de calcul
+    int encoders; // Nombre de threads d'encodage JPEG des flux MJPEG
+
+    static SchedulerConfig load(const std::string& filename);
+    static SchedulerConfig defaults();
+};
+
+// Ordonnanceur central : threads dédiés épinglés et pool de calcul à vol de tâches
+class TaskScheduler {
+
+    public:
+
+    static TaskScheduler& instance();
+
+    void start(const SchedulerConfig& config);
+    void stop();
+
+    // Thread dédié, placé selon sa classe et suivi dans /threads
+    std::thread spawn(const std::string& name, StageClass stageClass, std::function<void()> fn);
+
+    // Place et suit un thread emprunté (handler du serveur HTTP) pour la durée d'un bloc :
+    // ses cœurs et sa priorité d'origine sont rétablis à la sortie et il quitte /threads
+    class Adoption {
+        public:
+        Adoption(const std::string& name, StageClass stageClass);
+        ~Adoption();
+        Adoption(const Adoption&) = delete;
+        Adoption& operator=(const Adoption&) = delete;
+
+        private:
+        bool active;          // Faux si le thread est déjà adopté par un bloc englobant
+        bool cpusSaved;
+        cpu_set_t previousCpus;
+        bool niceSaved;
+        int previousNice;
+    };
+
+    // Tâche de calcul exécutée par le pool
+    std::future<void> submit(std::function<void()> task);
+
+    // Exécute des tâches en parallèle et attend leur fin ; le thread appelant
+    // participe au lieu de bloquer, ce qui évite les interblocages dans le pool
+    void runAll(std::vector<std::function<void()>>& tasks);
+
+    // Utilisation CPU par thread au format JSON
+    std::string threadsJson();
+
+    // Nom de chaque thread suivi, par identifiant Linux (tid)
+    std::map<int, std::string> threadNames();
+
+    static const char* stageClassName(StageClass stageClass);
+
+    private:
+
+    TaskScheduler();
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+    };
+
+    struct ThreadInfo {
+        std::string name;
+        StageClass stageClass;
+        long ticks;
+        std::chrono::steady_clock::time_point sampleTime;
+    };
+
+    void workerLoop(int index);
+    bool tryRunOne();
+    void applyPlacement(StageClass stageClass, bool reversible = false);
+    void registerThread(const std::string& name, StageClass stageClass);
+    void unregisterThread();
+
+    SchedulerConfig config;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCond;
+    std::atomic<int> pending;
+    std::atomic<unsigned> nextWorker;
+    bool stopping;
+
+    std::mutex registryMutex;
+    std::map<int, ThreadInfo> threads;  // Par identifiant Linux (tid)
+
+    static thread_local int workerIndex;
+    static thread_local bool adopted;
+};
@@ -1,3 +1,4 @@
 #pragma once
 
-#define NB_WEBCAMS 2
+// Nombre de caméras d'une paire stéréo (le nombre total de caméras est lu à l'exécution)
+#define STEREO_CAMERAS 2
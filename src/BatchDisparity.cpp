@@ -0,0 +1,267 @@
+#include "BatchDisparity.hpp"
+#include "CensusMatcher.hpp"
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static const char* STEP_NAMES[] = {"read", "rectify", "match", "write"};
+
+// Noms des images gauche et droite d'une même paire : xxx-left / xxx-right, stock de
+// calibration (pair-NNNN-camera1 / pair-NNNN-camera2), ancien format (camera0-N / camera1-N).
+// camera1 est essayé d'abord comme image gauche : il ne devient droite que sans camera2.
+static const char* PAIR_TOKENS[][2] = {{"left", "right"}, {"camera1", "camera2"}, {"camera0", "camera1"}};
+
+static long elapsedMicros(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start).count();
+}
+
+BatchDisparity::BatchDisparity(const BatchConfig& config)
+    : config(config), next(0), done(0), failed(0) {
+    for (std::atomic<long>& micros : stepMicros) micros = 0;
+}
+
+int BatchDisparity::run() {
+    bool listed = fs::is_directory(config.input) ? listDirectory() : listRecording();
+    if (!listed || items.empty()) {
+        std::cerr << "Erreur : aucune paire d'images dans " << config.input << std::endl;
+        return 1;
+    }
+
+    // La taille de la première paire fixe celle de la calibration
+    cv::Mat left, right;
+    if (!readPair(items[0], left, right)) {
+        std::cerr << "Erreur : paire illisible : " << items[0].name << std::endl;
+        return 1;
+    }
+    bool bundle = fs::path(config.calibration).extension() == ".bin";
+    ctx = bundle ? RectificationContext::fromBundle(config.calibration, left.size())
+                 : RectificationContext::fromFile(config.calibration, left.size());
+    if (!ctx) {
+        std::cerr << "Erreur : calibration absente ou incompatible : " << config.calibration << std::endl;
+        return 1;
+    }
+
+    std::error_code error;
+    fs::create_directories(config.output, error);
+    if (error) {
+        std::cerr << "Erreur : impossible de créer " << config.output << " : " << error.message() << std::endl;
+        return 1;
+    }
+
+    // Le parallélisme est entre les images : OpenCV reste sur un seul thread par image
+    int nbThreads = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    cv::setNumThreads(1);
+
+    std::cout << items.size() << " paires, " << nbThreads << " threads, moteur "
+              << (config.census ? "census" : "StereoBM") << std::endl;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0 ; i < nbThreads ; i++) {
+        threads.push_back(TaskScheduler::instance().spawn("batch/" + std::to_string(i), STAGE_COMPUTE,
+                                                          [this]() { worker(); }));
+    }
+
+    // Progression, une ligne par seconde au plus
+    size_t total = items.size();
+    while ((size_t)(done + failed) < total) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        double seconds = elapsedMicros(start) / 1e6;
+        std::cout << "\r" << (done + failed) << "/" << total << " ("
+                  << (int)(done / std::max(seconds, 1e-3)) << " images/s)" << std::flush;
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds = elapsedMicros(start) / 1e6;
+    std::cout << std::endl;
+
+    std::string summary = summaryJson(seconds, nbThreads);
+    std::ofstream(config.output + "/summary.json") << summary << std::endl;
+    std::cout << summary << std::endl;
+
+    return failed > 0 ? 2 : 0;
+}
+
+// Paires d'un dossier (voir PAIR_TOKENS), triées par nom
+bool BatchDisparity::listDirectory() {
+    std::vector<fs::path> files;
+    for (const fs::directory_entry& entry : fs::directory_iterator(config.input)) {
+        if (entry.is_regular_file()) files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    for (const fs::path& file : files) {
+        std::string filename = file.filename().string();
+        for (const auto& tokens : PAIR_TOKENS) {
+            size_t position = filename.find(tokens[0]);
+            if (position == std::string::npos) continue;
+
+            std::string partner = filename;
+            partner.replace(position, strlen(tokens[0]), tokens[1]);
+            fs::path partnerPath = file.parent_path() / partner;
+            if (!fs::exists(partnerPath)) continue;
+
+            // Nom de sortie : nom du fichier sans le côté ni l'extension
+            std::string stem = file.stem().string();
+            stem.erase(stem.find(tokens[0]), strlen(tokens[0]));
+            size_t first = stem.find_first_not_of("-_.");
+            size_t last = stem.find_last_not_of("-_.");
+            stem = first == std::string::npos ? std::to_string(items.size()) : stem.substr(first, last - first + 1);
+
+            BatchItem item;
+            item.name = stem;
+            item.files[0] = file.string();
+            item.files[1] = partnerPath.string();
+            item.frames[0] = item.frames[1] = -1;
+            items.push_back(item);
+            break;
+        }
+    }
+    return true;
+}
+
+// Chaque image gauche d'un enregistrement, avec l'image droite la plus proche dans le temps
+bool BatchDisparity::listRecording() {
+    recording = RecordingReader::open(config.input);
+    if (!recording) return false;
+
+    const std::vector<size_t>& lefts = recording->streamFrames(RECORD_LEFT);
+    const std::vector<size_t>& rights = recording->streamFrames(RECORD_RIGHT);
+    if (rights.empty()) return false;
+
+    // Les deux flux sont dans l'ordre chronologique : un seul parcours du flux droit
+    size_t right = 0;
+    for (size_t leftIndex : lefts) {
+        RecordedFrame frame = recording->frame(leftIndex);
+        while (right + 1 < rights.size() &&
+               std::llabs(recording->frame(rights[right + 1]).timestamp - frame.timestamp) <=
+               std::llabs(recording->frame(rights[right]).timestamp - frame.timestamp)) {
+            right++;
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "%06llu", (unsigned long long)frame.seq);
+        BatchItem item;
+        item.name = name;
+        item.frames[0] = (long)leftIndex;
+        item.frames[1] = (long)rights[right];
+        items.push_back(item);
+    }
+    return true;
+}
+
+// Images en niveaux de gris ; celles de l'enregistrement sont lues sans copie
+bool BatchDisparity::readPair(const BatchItem& item, cv::Mat& left, cv::Mat& right) {
+    cv::Mat* images[2] = {&left, &right};
+    for (int side = 0 ; side < 2 ; side++) {
+        cv::Mat image = recording ? recording->frame(item.frames[side]).image
+                                  : cv::imread(item.files[side], cv::IMREAD_UNCHANGED);
+        if (image.empty()) return false;
+        if (image.channels() == 3) {
+            cv::cvtColor(image, *images[side], cv::COLOR_BGR2GRAY);
+        } else {
+            *images[side] = image;
+        }
+    }
+    return left.size() == right.size();
+}
+
+void BatchDisparity::worker() {
+    // Moteur et buffers propres au thread, réutilisés d'une paire à l'autre
+    cv::Ptr<cv::StereoBM> stereo = cv::StereoBM::create(16, 15);
+    CensusMatcher census(16, 9);
+    cv::Mat left, right, rectified1, rectified2, disparity16, output, depth;
+
+    while (true) {
+        size_t index = next.fetch_add(1);
+        if (index >= items.size()) break;
+        const BatchItem& item = items[index];
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!readPair(item, left, right) || left.size() != ctx->imageSize) {
+            std::cerr << std::endl << "Erreur : paire illisible ou d'une autre taille : " << item.name << std::endl;
+            failed++;
+            continue;
+        }
+        stepMicros[STEP_READ] += elapsedMicros(start);
+
+        start = std::chrono::steady_clock::now();
+        cv::remap(left, rectified1, ctx->map1xy, ctx->map1frac, cv::INTER_LINEAR);
+        cv::remap(right, rectified2, ctx->map2xy, ctx->map2frac, cv::INTER_LINEAR);
+        stepMicros[STEP_RECTIFY] += elapsedMicros(start);
+
+        start = std::chrono::steady_clock::now();
+        if (config.census) {
+            census.compute(rectified1, rectified2, disparity16);
+        } else {
+            stereo->compute(rectified1, rectified2, disparity16);
+        }
+        stepMicros[STEP_MATCH] += elapsedMicros(start);
+
+        // Disparité brute x16 sur 16 bits, les pixels invalides (négatifs) à 0
+        start = std::chrono::steady_clock::now();
+        disparity16.convertTo(output, CV_16U);
+        bool written = cv::imwrite(config.output + "/" + item.name + "-disparity.png", output);
+        if (config.depth) writeDepth(disparity16, depth, config.output + "/" + item.name + "-depth.png");
+        stepMicros[STEP_WRITE] += elapsedMicros(start);
+
+        if (written) {
+            done++;
+        } else {
+            std::cerr << std::endl << "Erreur : écriture impossible dans " << config.output << std::endl;
+            failed++;
+        }
+    }
+}
+
+// Profondeur par Q : Z = Q[2][3] / (d * Q[3][2] + Q[3][3]), en millimètres (calibration en mètres)
+void BatchDisparity::writeDepth(const cv::Mat& disparity16, cv::Mat& depth, const std::string& filename) {
+    double focal = ctx->Q.at<double>(2, 3);
+    double inverseBaseline = ctx->Q.at<double>(3, 2);
+    double offset = ctx->Q.at<double>(3, 3);
+
+    depth.create(disparity16.size(), CV_16U);
+    for (int y = 0 ; y < disparity16.rows ; y++) {
+        const short* d = disparity16.ptr<short>(y);
+        ushort* z = depth.ptr<ushort>(y);
+        for (int x = 0 ; x < disparity16.cols ; x++) {
+            double w = d[x] / 16.0 * inverseBaseline + offset;
+            double millimeters = d[x] > 0 && w != 0 ? std::fabs(focal / w) * 1000 : 0;
+            z[x] = (ushort)std::min(millimeters, 65535.0);
+        }
+    }
+    cv::imwrite(filename, depth);
+}
+
+std::string BatchDisparity::summaryJson(double seconds, int threads) const {
+    std::ostringstream json;
+    json << "{\"input\":\"" << config.input << "\""
+         << ",\"engine\":\"" << (config.census ? "census" : "bm") << "\""
+         << ",\"threads\":" << threads
+         << ",\"pairs\":" << items.size()
+         << ",\"done\":" << done
+         << ",\"failed\":" << failed
+         << ",\"width\":" << ctx->imageSize.width
+         << ",\"height\":" << ctx->imageSize.height
+         << ",\"seconds\":" << seconds
+         << ",\"pairs_per_second\":" << (seconds > 0 ? done / seconds : 0);
+
+    // Temps moyen par paire de chaque étape (sur un thread)
+    json << ",\"steps_ms\":{";
+    for (int step = 0 ; step < NB_BATCH_STEPS ; step++) {
+        if (step > 0) json << ",";
+        json << "\"" << STEP_NAMES[step] << "\":" << (done > 0 ? stepMicros[step] / 1000.0 / done : 0);
+    }
+    json << "}}";
+    return json.str();
+}
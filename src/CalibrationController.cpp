@@ -1,23 +1,14 @@
 #include "CalibrationController.hpp"
 
-// Définition des variables statiques
-std::mutex CalibrationController::chessboardMutexes[NB_WEBCAMS];
-cv::Mat CalibrationController::chessboards[NB_WEBCAMS];
-bool CalibrationController::running;
-bool CalibrationController::capturing;
-int CalibrationController::nbImages;
-IndexController* CalibrationController::indexCtrl;
-cv::Size CalibrationController::boardSize;
-int CalibrationController::cameraID[NB_WEBCAMS];
-int CalibrationController::boardHeight;
-int CalibrationController::boardWidth;
-float CalibrationController::squareSize;
-std::thread CalibrationController::calibThread1;
-std::thread CalibrationController::calibThread2;
-
-CalibrationController::CalibrationController(struct mg_context* ctx, IndexController* indexCtrl) {
-
-    this->indexCtrl = indexCtrl;
+CalibrationController::CalibrationController(struct mg_context* ctx, CaptureManager* captureManager,
+                                             const StereoPairConfig& pair, DisparityController* disparityCtrl,
+                                             bool legacyRoutes) {
+
+    this->captureManager = captureManager;
+    this->disparityCtrl = disparityCtrl;
+    this->pair = pair;
+    imagesDir = pair.dataDir + "/images";
+    calibrationDir = pair.dataDir + "/calibration";
 
      // C'est le nombre de COINS INTERNES et pas de cases (donc pour 8*6 cases il faut 7*5 coins)
     boardWidth = 7;
@@ -25,54 +16,101 @@ CalibrationController::CalibrationController(struct mg_context* ctx, IndexContro
     squareSize = 0.019f; // Taille réelle des carrés en mètres
     boardSize = cv::Size(boardWidth, boardHeight);
 
-    // Initialise le nombre d'images
-    nbImages = nbImagesInMemory();
+    // Stock des images : seul le manifeste est lu (les dossiers d'une nouvelle paire sont créés)
+    store.reset(new CalibrationStore(imagesDir, pair.name, boardSize));
 
     // Initialise les identifiants des caméras
-    cameraID[0] = 0;
-    cameraID[1] = 1;
+    cameraID[0] = pair.left;
+    cameraID[1] = pair.right;
+
+    chessboardDemand.reset(new StreamDemand(pair.name + "/chessboard"));
+    for (int i = 0 ; i < STEREO_CAMERAS ; i++) {
+        chessboardDemands[i].reset(new StreamDemand(pair.name + "/chessboard" + std::to_string(i + 1)));
+        detectionTraces[i] = FrameTracer::intern(chessboardDemands[i]->getName());
+
+        // Echiquier en niveaux de gris : encodé sans conversion, une fois par détection
+        int encodeID = EncodeService::instance().addStream(chessboardDemands[i]->getName(),
+            [this, i](cv::Mat& frame, FrameInfo& info) {
+                std::lock_guard<std::mutex> lock(chessboardMutexes[i]);
+                if (chessboards[i].empty()) return false;
+                chessboards[i].copyTo(frame);
+                info = chessboardInfos[i];
+                return true;
+            });
+        streamParams[i] = {this, i, encodeID};
+    }
+
+    autoCapture = false;
+    lastPoseValid = false;
+    autoSaved = 0;
+    for (int i = 0 ; i < STEREO_CAMERAS ; i++) detectionFound[i] = false;
 
     // Lance les threads de capture vidéo
-    calibThread1 = std::thread(CalibrationController::calibThread, cameraID[0]);
-    calibThread2 = std::thread(CalibrationController::calibThread, cameraID[1]);
+    running = true;
+    capturing = true;
+    detectionThread = TaskScheduler::instance().spawn(pair.name + "/chessboard", STAGE_COMPUTE,
+                                                      [this]() { calibThread(); });
 
-    // Configure les handlers
+    // Configure les handlers, sous /<paire>/ et à la racine pour la première paire
     if(ctx == nullptr) {
         std::cerr << "Erreur : impossible de démarrer le serveur HTTP." << std::endl;
         running = false;
     } else {
-        mg_set_request_handler(ctx, "/chessboard1", streamHandler, &cameraID[0]);
-        mg_set_request_handler(ctx, "/chessboard2", streamHandler, &cameraID[1]);
-        mg_set_request_handler(ctx, "/erase", eraseButtonHandler, nullptr);
-        mg_set_request_handler(ctx, "/saveFrames", saveButtonHandler, nullptr);
-        mg_set_request_handler(ctx, "/calibrate", calibrateButtonHandler, nullptr);
-        mg_set_request_handler(ctx, "/calibration", rootHandler, nullptr);
+        std::vector<std::string> prefixes = {"/" + pair.name};
+        if (legacyRoutes) prefixes.push_back("");
+
+        for (const std::string& prefix : prefixes) {
+            mg_set_request_handler(ctx, (prefix + "/chessboard1").c_str(), streamHandler, &streamParams[0]);
+            mg_set_request_handler(ctx, (prefix + "/chessboard2").c_str(), streamHandler, &streamParams[1]);
+            mg_set_request_handler(ctx, (prefix + "/erase").c_str(), eraseButtonHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/saveFrames").c_str(), saveButtonHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/calibrate").c_str(), calibrateButtonHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/autoCapture").c_str(), autoCaptureHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/calibration").c_str(), rootHandler, this);
+        }
         running = true;
     }
+}
 
-    capturing = true;
+void CalibrationController::stop() {
+    running = false;
 }
 
 CalibrationController::~CalibrationController() {
-    running = false;
-    calibThread1.join();
-    calibThread2.join();
+    stop();
+    for (const StreamParam& stream : streamParams) EncodeService::instance().removeStream(stream.encodeID);
+    detectionThread.join();
+    setAutoCapture(false);
 }
 
 // Gestion du bouton
 int CalibrationController::saveButtonHandler(struct mg_connection *conn, void *param) {
-    saveFrames();
+    CalibrationController *ctrl = (CalibrationController *)(param);
+    int id = ctrl->saveFrames();
+    if (id < 0) {
+        mg_printf(conn,
+                  "HTTP/1.1 503 Service Unavailable\r\n"
+                  "Content-Type: text/plain\r\n\r\n"
+                  "No frame available!");
+        return 503;
+    }
 
+    // L'identifiant est rendu tout de suite, l'écriture se fait en arrière-plan
+    std::string json = "{\"id\":" + std::to_string(id) + "}";
     mg_printf(conn,
               "HTTP/1.1 200 OK\r\n"
-              "Content-Type: text/plain\r\n\r\n"
-              "Success!");
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
     return 200;
 }
 
 // Gestion du bouton
 int CalibrationController::eraseButtonHandler(struct mg_connection *conn, void *param) {
-    eraseFrames();
+    CalibrationController *ctrl = (CalibrationController *)(param);
+    ctrl->eraseFrames();
 
     mg_printf(conn,
               "HTTP/1.1 200 OK\r\n"
@@ -83,7 +121,8 @@ int CalibrationController::eraseButtonHandler(struct mg_connection *conn, void *
 
 // Gestion du bouton
 int CalibrationController::calibrateButtonHandler(struct mg_connection *conn, void *param) {
-    calibrateCameras();
+    CalibrationController *ctrl = (CalibrationController *)(param);
+    ctrl->calibrateCameras();
 
     mg_printf(conn,
               "HTTP/1.1 200 OK\r\n"
@@ -93,90 +132,69 @@ int CalibrationController::calibrateButtonHandler(struct mg_connection *conn, vo
 }
 
 // Thread qui reprends l'image et tente de trouver l'échiquier
-void CalibrationController::calibThread(int camID) {
+void CalibrationController::calibThread() {
+    std::vector<std::function<void()>> tasks;
+
     while(running){
         std::this_thread::sleep_for(std::chrono::milliseconds(33)); // ~30 FPS
-        if(capturing) continue;
-
-        cv::Mat frame = indexCtrl->getFrameById(camID);
-        if(frame.empty()) continue;
+        if(!capturing) continue;
 
-        // Conversion de l'image en nuaces de gris
-        cv::Mat gray;
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        // Pas de détection tant que personne ne regarde un des échiquiers
+        if(!chessboardDemand->waitForSubscribers(running)) continue;
 
-        // Recherche de l'échiquier
-        std::vector<cv::Point2f> corners;
-        bool found = cv::findChessboardCorners(gray, boardSize, corners,
-                        cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE);
-
-        if(found) {            
-            // Affichage de l'échiquier
-            cv::cornerSubPix(gray, corners, cv::Size(11, 11), cv::Size(-1, -1),
-                             cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.1));
-            cv::drawChessboardCorners(gray, boardSize, corners, found);
+        // Une tâche par caméra regardée, exécutées en parallèle
+        tasks.clear();
+        for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+            detectionFound[side] = false;
+            if (chessboardDemands[side]->poll()) {
+                tasks.push_back([this, side]() { detectChessboard(side); });
+            }
         }
+        TaskScheduler::instance().runAll(tasks);
 
-        {
-            std::lock_guard<std::mutex> lock(chessboardMutexes[camID]);
-            chessboards[camID] = gray.clone();
-        }
+        if (autoCapture) autoCaptureStep();
     }
 }
 
-// Lecture du nombre d'images déj'a présentes par caméra
-int CalibrationController::nbImagesInMemoryByCamID(int camID) {
-    int cpt = 0;
-    std::string directoryPath = "./data/images";
-
-    std::regex pattern("^camera" + std::to_string(camID) + ".*\\.jpg$");
-
-    try {
-        // Parcourir les fichiers dans le dossier
-        for (const auto& entry : fs::directory_iterator(directoryPath)) {
-            // Vérifier si l'entrée est un fichier régulier
-            if (fs::is_regular_file(entry)) {
-                // Extraire le nom du fichier
-                std::string filename = entry.path().filename().string();
-
-                // Vérifier si le nom du fichier correspond au modèle
-                if (std::regex_match(filename, pattern)) {
-                    ++cpt;
-                }
-            }
-        }
+// Recherche de l'échiquier sur l'image courante d'une caméra
+void CalibrationController::detectChessboard(int side) {
+    cv::Mat& frame = detectionFrames[side];
+    cv::Mat& gray = detectionGrays[side];
+    std::vector<cv::Point2f>& corners = detectionCorners[side];
 
-        // Afficher le nombre de fichiers correspondants
-        return cpt;
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "Erreur : " << e.what() << std::endl;
-        return -1;
-    }
-}
+    // L'image publiée est échangée avec le buffer de travail : deux images de mise en route
+    FramePool::Frame poolFrame(chessboardDemands[side]->getName(), 2);
+    if(!captureManager->copyFrameById(cameraID[side], frame, &detectionInfos[side])) return;
+    FrameTracer::Span span(detectionTraces[side], detectionInfos[side].seq);
 
-// Lecture du nombre de combinaisons d'images déjà présentes
-int CalibrationController::nbImagesInMemory() {
-    if (NB_WEBCAMS < 2) {
-        std::cerr << "Erreur : il doit y avoir au moins deux cameras" << std::endl;
-        return -1;
-    }
+    // Conversion de l'image en nuaces de gris
+    FramePool::ensure(gray, frame.size(), CV_8UC1);
+    cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
 
-    int nbCombinations = nbImagesInMemoryByCamID(0);
+    // Recherche de l'échiquier
+    bool found = CalibrationStore::findCorners(gray, boardSize, corners);
 
-    for (int i = 1 ; i < NB_WEBCAMS ; i++) {
-        int nbCurrentImages = nbImagesInMemoryByCamID(i);
-        if (nbCombinations < nbCurrentImages) {
-            nbCombinations = nbCurrentImages;
-        }
+    if(found) {
+        // Affichage de l'échiquier
+        cv::drawChessboardCorners(gray, boardSize, corners, found);
     }
+    detectionFound[side] = found;
 
-    std::cout << "Nombre de combinaisons d'images : " << std::to_string(nbCombinations) << std::endl;
-    return nbCombinations;
+    {
+        std::lock_guard<std::mutex> lock(chessboardMutexes[side]);
+        cv::swap(chessboards[side], gray);
+        chessboardInfos[side] = detectionInfos[side];
+    }
+    EncodeService::instance().notify(streamParams[side].encodeID);
 }
 
 // Gestionnaire de la requête, affiche le flux MJPEG
 int CalibrationController::streamHandler(struct mg_connection *conn, void *param) {
-    int *cameraID = (int *)(param);
+    StreamParam *stream = (StreamParam *)(param);
+    CalibrationController *ctrl = stream->ctrl;
+    StreamDemand::Subscription pairSubscription(*ctrl->chessboardDemand);
+    StreamDemand::Subscription subscription(*ctrl->chessboardDemands[stream->side]);
+    TaskScheduler::Adoption adoption("http", STAGE_ENCODE);
 
     // En-têtes pour le flux MJPEG
     mg_printf(conn,
@@ -185,57 +203,145 @@ int CalibrationController::streamHandler(struct mg_connection *conn, void *param
               "Cache-Control: no-cache\r\n"
               "\r\n");
 
-    while (running) {
-        std::vector<uchar> buf;
+    EncodeService::Subscription encodeSubscription(stream->encodeID);
+    const char* writeTrace = FrameTracer::intern("write/" + ctrl->chessboardDemands[stream->side]->getName());
+    uint64_t lastSeq = 0;
+
+    while (ctrl->running) {
+        std::shared_ptr<const EncodedFrame> frame = EncodeService::instance().waitForFrame(stream->encodeID, lastSeq, 500);
+        if (!frame) continue;
+        lastSeq = frame->seq;
+
+        FrameTracer::Span span(writeTrace, frame->seq);
+        mg_printf(conn,
+                  "--frame\r\n"
+                  "Content-Type: image/jpeg\r\n"
+                  "X-Frame-Seq: %llu\r\n"
+                  "X-Capture-Timestamp: %lld\r\n"
+                  "Content-Length: %lu\r\n\r\n",
+                  (unsigned long long)frame->seq, (long long)frame->timestamp, frame->data.size());
+        // Le client s'est déconnecté
+        if (mg_write(conn, frame->data.data(), frame->data.size()) <= 0) break;
+        mg_printf(conn, "\r\n");
+    }
+
+    return 200; // Réponse HTTP réussie
+}
+
+// Capture automatique : /autoCapture (état), /autoCapture?enable=1|0
+int CalibrationController::autoCaptureHandler(struct mg_connection *conn, void *param) {
+    CalibrationController *ctrl = (CalibrationController *)(param);
+    const struct mg_request_info *info = mg_get_request_info(conn);
+    char enable[8] = "";
 
-        {
-            std::lock_guard<std::mutex> lock(chessboardMutexes[*cameraID]);
-            if (!chessboards[*cameraID].empty()) {
-                cv::imencode(".jpg", chessboards[*cameraID], buf);
+    if (info->query_string != nullptr &&
+        mg_get_var(info->query_string, strlen(info->query_string), "enable", enable, sizeof(enable)) > 0) {
+        ctrl->setAutoCapture(strcmp(enable, "1") == 0);
+    }
+
+    std::string json = ctrl->autoCaptureJson();
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
+    return 200;
+}
+
+// La couverture repart des couples déjà enregistrés
+void CalibrationController::setAutoCapture(bool enable) {
+    std::lock_guard<std::mutex> lock(autoCaptureMutex);
+    if (enable == autoCapture) return;
+
+    if (enable) {
+        coverage.clear();
+        store->flush();
+        for (const CalibrationPair& pair : store->getPairs()) {
+            if (pair.detection[0] == DETECTION_FOUND && pair.detection[1] == DETECTION_FOUND) {
+                coverage.add(PoseCoverage::measure(pair.corners[0], boardSize, pair.imageSize));
             }
         }
+        autoSaved = 0;
+        lastPoseValid = false;
 
-        if (!buf.empty()) {
-            mg_printf(conn,
-                      "--frame\r\n"
-                      "Content-Type: image/jpeg\r\n"
-                      "Content-Length: %lu\r\n\r\n",
-                      buf.size());
-            mg_write(conn, buf.data(), buf.size());
-            mg_printf(conn, "\r\n");
+        // La détection tourne sur les deux caméras, même sans personne devant les flux
+        autoSubscriptions[0].reset(new StreamDemand::Subscription(*chessboardDemand));
+        for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+            autoSubscriptions[side + 1].reset(new StreamDemand::Subscription(*chessboardDemands[side]));
         }
+    } else {
+        for (auto& subscription : autoSubscriptions) subscription.reset();
+    }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(33)); // ~30 FPS
+    autoCapture = enable;
+    std::cout << "Capture automatique (" << pair.name << ") : " << (enable ? "activée" : "désactivée") << std::endl;
+}
+
+// Appelé par le thread de détection après chaque passage
+void CalibrationController::autoCaptureStep() {
+    if (!detectionFound[0] || !detectionFound[1]) {
+        lastPoseValid = false;
+        return;
     }
 
-    return 200; // Réponse HTTP réussie
+    // L'échiquier doit être immobile sur deux détections de suite (pas de flou de bougé)
+    BoardPose pose = PoseCoverage::measure(detectionCorners[0], boardSize, detectionFrames[0].size());
+    bool stable = lastPoseValid && pose.distance(lastPose) < 0.01f;
+    lastPose = pose;
+    lastPoseValid = true;
+    if (!stable || std::chrono::steady_clock::now() - lastAutoSave < std::chrono::seconds(1)) return;
+
+    std::lock_guard<std::mutex> lock(autoCaptureMutex);
+    if (!autoCapture || !coverage.adds(pose)) return;
+
+    // Copies : les buffers de détection restent en place pour le passage suivant
+    cv::Mat frames[STEREO_CAMERAS];
+    for (int side = 0 ; side < STEREO_CAMERAS ; side++) frames[side] = detectionFrames[side].clone();
+    int id = store->add(frames);
+
+    coverage.add(pose);
+    autoSaved++;
+    lastAutoSave = std::chrono::steady_clock::now();
+    std::cout << "Couple " << id << " enregistré automatiquement : " << coverage.toJson() << std::endl;
+
+    if (coverage.complete()) {
+        for (auto& subscription : autoSubscriptions) subscription.reset();
+        autoCapture = false;
+        std::cout << "Capture automatique (" << pair.name << ") terminée : couverture atteinte." << std::endl;
+    }
 }
 
-// Enregistrement des images des deux caméras
-void CalibrationController::saveFrames() {
-    for (int i = 0 ; i < NB_WEBCAMS ; i++) {
-        std::string fileName = "./data/images/camera" + std::to_string(i) + "-" + std::to_string(nbImages) + ".jpg";
-        {
-             std::lock_guard<std::mutex> lock(chessboardMutexes[i]);
-             cv::imwrite(fileName, indexCtrl->getFrameById(i));
-        }
+std::string CalibrationController::autoCaptureJson() {
+    std::lock_guard<std::mutex> lock(autoCaptureMutex);
+    return "{\"enabled\":" + std::string(autoCapture ? "true" : "false") +
+           ",\"saved\":" + std::to_string(autoSaved) +
+           ",\"coverage\":" + coverage.toJson() + "}";
+}
+
+// Enregistrement des images des deux caméras, retourne l'identifiant du couple
+int CalibrationController::saveFrames() {
+    // Copie sous le verrou de l'image de chaque caméra, rien de plus
+    cv::Mat frames[STEREO_CAMERAS];
+    for (int i = 0 ; i < STEREO_CAMERAS ; i++) {
+        if (!captureManager->copyFrameById(cameraID[i], frames[i])) return -1;
     }
 
-    nbImages++;
+    return store->add(frames);
 }
 
 // Effacer toutes les images enregistrées
 void CalibrationController::eraseFrames() {
-    fs::remove_all("data/images/");
-    fs::create_directory("data/images/");
-    nbImages = 0;
+    store->clear();
 }
 
 // Sauvegarde du fichier de calibration
 void CalibrationController::saveCalibration(const std::string& filename,
                      const cv::Mat& cameraMatrix1, const cv::Mat& distCoeffs1,
                      const cv::Mat& cameraMatrix2, const cv::Mat& distCoeffs2,
-                     const cv::Mat& R, const cv::Mat& T) {
+                     const cv::Mat& R, const cv::Mat& T, const cv::Size& imageSize) {
+    // Export YAML lisible
     cv::FileStorage fs(filename, cv::FileStorage::WRITE);
     fs << "cameraMatrix1" << cameraMatrix1;
     fs << "distCoeffs1" << distCoeffs1;
@@ -244,6 +350,15 @@ void CalibrationController::saveCalibration(const std::string& filename,
     fs << "R" << R;
     fs << "T" << T;
     fs.release();
+
+    // Bundle binaire avec la rectification et les maps déjà calculées,
+    // chargé directement au démarrage
+    std::string bundleFilename = std::filesystem::path(filename).replace_extension(".bin").string();
+    std::shared_ptr<const RectificationContext> ctx = RectificationContext::fromCalibration(
+                     cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T, imageSize);
+    if (!ctx->saveBundle(bundleFilename)) {
+        std::cerr << "Erreur : impossible d'enregistrer " << bundleFilename << std::endl;
+    }
 }
 
 // Calibration des caméras
@@ -255,7 +370,7 @@ void CalibrationController::calibrateCameras() {
 
     std::vector<std::vector<cv::Point3f>> objectPoints;
     std::vector<std::vector<cv::Point2f>> imagePoints1, imagePoints2;
-    cv::Mat gray1, gray2;
+    cv::Size imageSize;
 
     std::vector<cv::Point3f> obj;
     for (int i = 0; i < boardHeight; i++) {
@@ -264,57 +379,25 @@ void CalibrationController::calibrateCameras() {
         }
     }
 
-    for (int i = 0 ; i < nbImages ; i++) {
-        std::cout << "Traitement image " << std::to_string(i) << std::endl;
-
-        // Lecture des images enregistrées
-        std::string filename1 = "./data/images/camera0-" + std::to_string(i) + ".jpg";
-        std::string filename2 = "./data/images/camera1-" + std::to_string(i) + ".jpg";
-        cv::Mat frame1 = cv::imread(filename1, 1);
-        cv::Mat frame2 = cv::imread(filename2, 1);
-
-        // Conversion en nuance de gris
-        cv::cvtColor(frame1, gray1, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(frame2, gray2, cv::COLOR_BGR2GRAY);
-
-        // Recherche de l'échiquier
-        std::vector<cv::Point2f> corners1, corners2;
-        bool found1 = cv::findChessboardCorners(gray1, boardSize, corners1,
-                        cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE);
-        bool found2 = cv::findChessboardCorners(gray2, boardSize, corners2,
-                        cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE);
-
-        if (found1 && found2){
-            // Affinage des coins de l'échiquier
-            cv::cornerSubPix(gray1, corners1, cv::Size(11, 11), cv::Size(-1, -1),
-                             cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.1));
-            cv::cornerSubPix(gray2, corners2, cv::Size(11, 11), cv::Size(-1, -1),
-                             cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.1));
-                             
-            // Dessine les coins de l'échiquier sur les images
-            cv::drawChessboardCorners(gray1, boardSize, corners1, found1);
-            cv::drawChessboardCorners(gray2, boardSize, corners2, found2);
-
-            // Enregistrement des coordonnées dans les tableaux
-            imagePoints1.push_back(corners1);
-            imagePoints2.push_back(corners2);
+    // Les coins ont été cherchés à l'enregistrement : aucune image n'est relue
+    store->flush();
+    for (const CalibrationPair& pair : store->getPairs()) {
+        if (pair.detection[0] == DETECTION_FOUND && pair.detection[1] == DETECTION_FOUND) {
+            imagePoints1.push_back(pair.corners[0]);
+            imagePoints2.push_back(pair.corners[1]);
             objectPoints.push_back(obj);
+            imageSize = pair.imageSize;
         } else {
-            std::cerr << "Erreur! Pas d'échiquier trouvé!!!" << std::endl;
-        }
-        
-        // Affichage à l'écran des images avec l'échiquier
-        {
-            std::lock_guard<std::mutex> lock(chessboardMutexes[0]);
-            chessboards[0] = gray1.clone();
-        }
-        
-        {
-            std::lock_guard<std::mutex> lock(chessboardMutexes[1]);
-            chessboards[1] = gray2.clone();
+            std::cerr << "Erreur! Pas d'échiquier trouvé sur le couple " << pair.id << std::endl;
         }
     }
 
+    if (objectPoints.size() < 3) {
+        std::cerr << "Erreur : pas assez de couples avec l'échiquier pour calibrer." << std::endl;
+        capturing = true;
+        return;
+    }
+
     // Calibration des caméras
     std::cout << "Calibration caméras" << std::endl;
     std::cout << "Taille nb objets : " << std::to_string(objectPoints.size()) << std::endl;
@@ -324,51 +407,31 @@ void CalibrationController::calibrateCameras() {
     cv::Mat R, T, E, F;
 
     std::cout << "Caméra 1" << std::endl;
-    cv::calibrateCamera(objectPoints, imagePoints1, gray1.size(), cameraMatrix1, distCoeffs1, cv::noArray(), cv::noArray());
+    cv::calibrateCamera(objectPoints, imagePoints1, imageSize, cameraMatrix1, distCoeffs1, cv::noArray(), cv::noArray());
     std::cout << "Caméra 2" << std::endl;
-    cv::calibrateCamera(objectPoints, imagePoints2, gray2.size(), cameraMatrix2, distCoeffs2, cv::noArray(), cv::noArray());
+    cv::calibrateCamera(objectPoints, imagePoints2, imageSize, cameraMatrix2, distCoeffs2, cv::noArray(), cv::noArray());
     std::cout << "Stéréovision" << std::endl;
     cv::stereoCalibrate(objectPoints, imagePoints1, imagePoints2,
                         cameraMatrix1, distCoeffs1,
                         cameraMatrix2, distCoeffs2,
-                        gray1.size(), R, T, E, F,
+                        imageSize, R, T, E, F,
                         cv::CALIB_FIX_INTRINSIC,
                         cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 100, 1e-5));
 
     // Sauvegarder les paramètres de calibration
-    saveCalibration("./data/calibration/stereo_calib.yml", cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T);
+    fs::create_directories(calibrationDir);
+    saveCalibration(calibrationDir + "/stereo_calib.yml", cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T, imageSize);
+
+    // Le flux de disparité bascule sur la nouvelle calibration sans interruption
+    disparityCtrl->requestCalibrationReload();
 
     // Relance les threads
     capturing = true;
 
-    std::cout << "Calibration terminée et sauvegardée dans './data/calibration/stereo_calib.yml'." << std::endl;
+    std::cout << "Calibration terminée et sauvegardée dans '" << calibrationDir << "/stereo_calib.yml'." << std::endl;
 }
 
 // Gestion de la page HTML
 int CalibrationController::rootHandler(struct mg_connection *conn, void *param) {
-    FILE *file = fopen("resources/calibration.html", "r");
-    if (!file) {
-        mg_printf(conn,
-                  "HTTP/1.1 404 Not Found\r\n"
-                  "Content-Type: text/plain\r\n\r\n"
-                  "File not found!");
-        return 404;
-    }
-
-    // Lire le contenu du fichier
-    fseek(file, 0, SEEK_END);
-    size_t fileSize = ftell(file);
-    rewind(file);
-    std::vector<char> fileContent(fileSize);
-    fread(fileContent.data(), 1, fileSize, file);
-    fclose(file);
-
-    // Envoyer la réponse
-    mg_printf(conn,
-              "HTTP/1.1 200 OK\r\n"
-              "Content-Type: text/html\r\n"
-              "Content-Length: %zu\r\n\r\n",
-              fileSize);
-    mg_write(conn, fileContent.data(), fileSize);
-    return 200;
+    return StaticResources::serve(conn, "calibration.html");
 }
@@ -0,0 +1,328 @@
+#include "CalibrationStore.hpp"
+#include "TaskScheduler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+CalibrationStore::CalibrationStore(const std::string& dir, const std::string& name, const cv::Size& boardSize) {
+    this->dir = dir;
+    this->boardSize = boardSize;
+    manifestFile = dir + "/manifest.yml";
+    nextId = 0;
+    generation = 0;
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    loadManifest();
+
+    // Les images importées sans détection sont traitées par le thread d'écriture
+    writing = false;
+    for (const CalibrationPair& pair : pairs) {
+        for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+            if (pair.detection[side] == DETECTION_PENDING) writing = true;
+        }
+    }
+
+    running = true;
+    writer = TaskScheduler::instance().spawn(name + "/calibration-store", STAGE_SERVICE, [this]() { writerThread(); });
+}
+
+// Les couples en attente sont écrits avant l'arrêt
+CalibrationStore::~CalibrationStore() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    queueCond.notify_all();
+    writer.join();
+}
+
+int CalibrationStore::add(cv::Mat frames[STEREO_CAMERAS]) {
+    PendingPair pending;
+    for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+        cv::swap(pending.frames[side], frames[side]);
+        pending.pair.detection[side] = DETECTION_PENDING;
+    }
+    pending.pair.imageSize = pending.frames[0].size();
+    pending.pair.timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextId++;
+        pending.pair.id = id;
+        for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+            char filename[64];
+            snprintf(filename, sizeof(filename), "pair-%04d-camera%d.png", id, side + 1);
+            pending.pair.files[side] = filename;
+        }
+        queue.push_back(std::move(pending));
+    }
+    queueCond.notify_all();
+    return id;
+}
+
+void CalibrationStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCond.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+void CalibrationStore::clear() {
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.clear();
+        pairs.clear();
+        nextId = 0;
+        generation++;
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(dir, error);
+    std::filesystem::create_directories(dir, error);
+}
+
+std::vector<CalibrationPair> CalibrationStore::getPairs() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pairs;
+}
+
+int CalibrationStore::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)pairs.size();
+}
+
+bool CalibrationStore::findCorners(const cv::Mat& gray, const cv::Size& boardSize, std::vector<cv::Point2f>& corners) {
+    corners.clear();
+    bool found = cv::findChessboardCorners(gray, boardSize, corners,
+                    cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE);
+    if (found) {
+        cv::cornerSubPix(gray, corners, cv::Size(11, 11), cv::Size(-1, -1),
+                         cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.1));
+    }
+    return found;
+}
+
+// Détection de l'échiquier sur les images du couple, telles qu'enregistrées
+void CalibrationStore::detect(CalibrationPair& pair, const cv::Mat frames[STEREO_CAMERAS]) {
+    cv::Mat gray;
+    for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+        if (frames[side].empty()) {
+            pair.detection[side] = DETECTION_NOT_FOUND;
+            continue;
+        }
+        cv::cvtColor(frames[side], gray, cv::COLOR_BGR2GRAY);
+        pair.detection[side] = findCorners(gray, boardSize, pair.corners[side]) ? DETECTION_FOUND : DETECTION_NOT_FOUND;
+    }
+    pair.imageSize = frames[0].size();
+}
+
+void CalibrationStore::writerThread() {
+    // Images importées de l'ancien format : la détection est faite une seule fois
+    std::vector<CalibrationPair> imported;
+    int importGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const CalibrationPair& pair : pairs) {
+            if (pair.detection[0] == DETECTION_PENDING || pair.detection[1] == DETECTION_PENDING) imported.push_back(pair);
+        }
+        importGeneration = generation;
+    }
+    if (!imported.empty()) {
+        for (CalibrationPair& pair : imported) {
+            cv::Mat frames[STEREO_CAMERAS];
+            for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+                frames[side] = cv::imread(dir + "/" + pair.files[side], cv::IMREAD_COLOR);
+            }
+            detect(pair, frames);
+        }
+
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        std::vector<CalibrationPair> snapshot;
+        int snapshotNextId = 0;
+        bool current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = importGeneration == generation;
+            if (current) {
+                for (CalibrationPair& pair : pairs) {
+                    for (const CalibrationPair& detected : imported) {
+                        if (pair.id == detected.id) pair = detected;
+                    }
+                }
+                snapshot = pairs;
+                snapshotNextId = nextId;
+            }
+        }
+        if (current) saveManifest(snapshot, snapshotNextId);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = false;
+        }
+        idleCond.notify_all();
+    }
+
+    while (true) {
+        PendingPair pending;
+        int pendingGeneration;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueCond.wait(lock, [this] { return !queue.empty() || !running; });
+            if (queue.empty()) break;
+            pending = std::move(queue.front());
+            queue.pop_front();
+            pendingGeneration = generation;
+            writing = true;
+        }
+
+        detect(pending.pair, pending.frames);
+
+        {
+            // Ecriture PNG sans perte, avec une compression faible pour aller vite ;
+            // clear() attend la fin de l'écriture avant d'effacer le dossier
+            std::lock_guard<std::mutex> fileLock(fileMutex);
+            bool written = true;
+            std::vector<int> params = {cv::IMWRITE_PNG_COMPRESSION, 1};
+            for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+                written = written && cv::imwrite(dir + "/" + pending.pair.files[side], pending.frames[side], params);
+            }
+
+            // Le manifeste est réécrit à partir d'une copie des couples, hors du verrou de l'état
+            std::vector<CalibrationPair> snapshot;
+            int snapshotNextId = 0;
+            bool current;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current = pendingGeneration == generation;
+                if (current && written) {
+                    pairs.push_back(pending.pair);
+                    snapshot = pairs;
+                    snapshotNextId = nextId;
+                }
+            }
+
+            if (!current) {
+                // Effacé pendant l'écriture : les fichiers ne doivent pas réapparaître
+                std::error_code error;
+                for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+                    std::filesystem::remove(dir + "/" + pending.pair.files[side], error);
+                }
+            } else if (!written) {
+                std::cerr << "Erreur : impossible d'écrire le couple " << pending.pair.id << " dans " << dir << std::endl;
+            } else {
+                saveManifest(snapshot, snapshotNextId);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = false;
+        }
+        idleCond.notify_all();
+    }
+}
+
+// Lecture du manifeste, ou import unique des images JPEG de l'ancien format
+void CalibrationStore::loadManifest() {
+    cv::FileStorage fs;
+    try {
+        fs.open(manifestFile, cv::FileStorage::READ);
+    } catch (const cv::Exception& e) {
+        std::cerr << "Erreur : manifeste illisible : " << e.what() << std::endl;
+    }
+
+    if (!fs.isOpened()) {
+        importLegacyImages();
+        return;
+    }
+
+    nextId = (int)fs["nextId"];
+    cv::FileNode nodes = fs["pairs"];
+    for (cv::FileNodeIterator it = nodes.begin() ; it != nodes.end() ; ++it) {
+        CalibrationPair pair;
+        pair.id = (int)(*it)["id"];
+        pair.timestamp = (double)(*it)["timestamp"];
+        pair.imageSize = cv::Size((int)(*it)["width"], (int)(*it)["height"]);
+
+        for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+            std::string n = std::to_string(side + 1);
+            pair.files[side] = (std::string)(*it)["file" + n];
+            pair.detection[side] = (int)(*it)["detection" + n];
+
+            cv::Mat corners;
+            (*it)["corners" + n] >> corners;
+            if (pair.detection[side] == DETECTION_FOUND && corners.type() == CV_32FC2 && corners.isContinuous()) {
+                const cv::Point2f* points = corners.ptr<cv::Point2f>();
+                pair.corners[side].assign(points, points + corners.total());
+            } else if (pair.detection[side] == DETECTION_FOUND) {
+                pair.detection[side] = DETECTION_PENDING;
+            }
+        }
+        pairs.push_back(pair);
+        nextId = std::max(nextId, pair.id + 1);
+    }
+    fs.release();
+
+    std::cout << "Nombre de combinaisons d'images : " << pairs.size() << std::endl;
+}
+
+void CalibrationStore::importLegacyImages() {
+    for (int i = 0 ; ; i++) {
+        CalibrationPair pair;
+        pair.id = i;
+        pair.timestamp = 0;
+        for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+            pair.files[side] = "camera" + std::to_string(side) + "-" + std::to_string(i) + ".jpg";
+            pair.detection[side] = DETECTION_PENDING;
+        }
+
+        std::error_code error;
+        if (!std::filesystem::exists(dir + "/" + pair.files[0], error) ||
+            !std::filesystem::exists(dir + "/" + pair.files[1], error)) break;
+        pairs.push_back(pair);
+    }
+    nextId = (int)pairs.size();
+
+    if (!pairs.empty()) {
+        std::cout << pairs.size() << " combinaison(s) d'images importée(s) dans " << manifestFile << std::endl;
+        saveManifest(pairs, nextId);
+    }
+}
+
+// Ecriture dans un fichier temporaire puis renommage : le manifeste est toujours complet
+bool CalibrationStore::saveManifest(const std::vector<CalibrationPair>& pairs, int nextId) {
+    std::string tmpFilename = dir + "/manifest.tmp.yml";
+    {
+        cv::FileStorage fs(tmpFilename, cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            std::cerr << "Erreur : impossible d'écrire " << tmpFilename << std::endl;
+            return false;
+        }
+
+        fs << "nextId" << nextId;
+        fs << "pairs" << "[";
+        for (const CalibrationPair& pair : pairs) {
+            fs << "{" << "id" << pair.id << "timestamp" << pair.timestamp
+               << "width" << pair.imageSize.width << "height" << pair.imageSize.height;
+            for (int side = 0 ; side < STEREO_CAMERAS ; side++) {
+                std::string n = std::to_string(side + 1);
+                fs << "file" + n << pair.files[side] << "detection" + n << pair.detection[side];
+                if (pair.detection[side] == DETECTION_FOUND) fs << "corners" + n << cv::Mat(pair.corners[side]);
+            }
+            fs << "}";
+        }
+        fs << "]";
+        fs.release();
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpFilename, manifestFile, error);
+    if (error) {
+        std::cerr << "Erreur : " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,221 @@
+#include "CaptureManager.hpp"
+#include "FramePool.hpp"
+#include "TaskScheduler.hpp"
+#include "FrameTracer.hpp"
+#include "FrameSource.hpp"
+
+#include <chrono>
+#include <sstream>
+
+// Lecture de la configuration
+CaptureConfig CaptureConfig::load(const std::string& filename) {
+    cv::FileStorage fs;
+    try {
+        fs.open(filename, cv::FileStorage::READ);
+    } catch (const cv::Exception& e) {
+        std::cerr << "Erreur : configuration illisible : " << e.what() << std::endl;
+    }
+
+    if (!fs.isOpened()) {
+        std::cout << "Pas de fichier " << filename << ", configuration par défaut." << std::endl;
+        return defaults();
+    }
+
+    CaptureConfig config;
+
+    cv::FileNode cameras = fs["cameras"];
+    for (cv::FileNodeIterator it = cameras.begin() ; it != cameras.end() ; ++it) {
+        CameraConfig camera;
+        camera.device = (int)(*it)["device"];
+        camera.name = (*it)["name"].empty() ? "camera" + std::to_string(config.cameras.size() + 1) : (std::string)(*it)["name"];
+        camera.width = (*it)["width"].empty() ? 640 : (int)(*it)["width"];
+        camera.height = (*it)["height"].empty() ? 480 : (int)(*it)["height"];
+        camera.fps = (*it)["fps"].empty() ? 30 : (int)(*it)["fps"];
+        if (!(*it)["source"].empty()) camera.source = (std::string)(*it)["source"];
+        if (!(*it)["file"].empty()) camera.file = (std::string)(*it)["file"];
+        if (!(*it)["stream"].empty()) camera.stream = (int)(*it)["stream"];
+        config.cameras.push_back(camera);
+    }
+
+    cv::FileNode pairs = fs["pairs"];
+    for (cv::FileNodeIterator it = pairs.begin() ; it != pairs.end() ; ++it) {
+        StereoPairConfig pair;
+        pair.name = (std::string)(*it)["name"];
+        pair.left = (int)(*it)["left"];
+        pair.right = (int)(*it)["right"];
+        pair.dataDir = (*it)["dataDir"].empty() ? "./data/" + pair.name : (std::string)(*it)["dataDir"];
+        pair.sharedMemory = !(*it)["sharedMemory"].empty() && (int)(*it)["sharedMemory"] != 0;
+        cv::FileNode obstacles = (*it)["obstacles"];
+        if (!obstacles["maxDistance"].empty()) pair.obstacleMaxDistance = (double)obstacles["maxDistance"];
+        if (!obstacles["minHeight"].empty()) pair.obstacleMinHeight = (double)obstacles["minHeight"];
+        if (!obstacles["maxHeight"].empty()) pair.obstacleMaxHeight = (double)obstacles["maxHeight"];
+
+        // Vérification de la paire
+        int nbCameras = (int)config.cameras.size();
+        if (pair.name.empty() || pair.left == pair.right ||
+            pair.left < 0 || pair.left >= nbCameras || pair.right < 0 || pair.right >= nbCameras) {
+            std::cerr << "Erreur : paire stéréo invalide ignorée : " << pair.name << std::endl;
+            continue;
+        }
+        config.pairs.push_back(pair);
+    }
+
+    fs.release();
+    return config;
+}
+
+CaptureConfig CaptureConfig::defaults() {
+    CaptureConfig config;
+    config.cameras.push_back({"camera1", 0, 640, 480, 30});
+    config.cameras.push_back({"camera2", 2, 640, 480, 30});
+    config.pairs.push_back({"stereo", 0, 1, "./data"});
+    return config;
+}
+
+// Constructeur : lance un thread de capture par caméra
+CaptureManager::CaptureManager(const CaptureConfig& config) {
+    running = true;
+    pairs = config.pairs;
+
+    for (const CameraConfig& cameraConfig : config.cameras) {
+        std::unique_ptr<Camera> camera(new Camera());
+        camera->config = cameraConfig;
+        cameras.push_back(std::move(camera));
+    }
+
+    for (size_t i = 0 ; i < cameras.size() ; i++) {
+        cameras[i]->thread = TaskScheduler::instance().spawn("capture/" + cameras[i]->config.name, STAGE_CAPTURE,
+                                                             [this, i]() { captureThread((int)i); });
+    }
+
+    std::cout << cameras.size() << " caméra(s), " << pairs.size() << " paire(s) stéréo." << std::endl;
+}
+
+// Destructeur
+CaptureManager::~CaptureManager() {
+    running = false;
+    for (auto& camera : cameras) {
+        if (camera->thread.joinable()) camera->thread.join();
+    }
+}
+
+// Thread séparé qui capture le flux d'une caméra
+void CaptureManager::captureThread(int camID) {
+    Camera& camera = *cameras[camID];
+
+    // Rôle dans la première paire qui utilise la caméra
+    CameraRole role = CAMERA_LEFT;
+    for (const StereoPairConfig& pair : pairs) {
+        if (pair.left == camID) break;
+        if (pair.right == camID) {
+            role = CAMERA_RIGHT;
+            break;
+        }
+    }
+
+    std::unique_ptr<FrameSource> source = FrameSource::create(camera.config, role);
+    if (!source) {
+        std::cerr << "Erreur : impossible d'ouvrir la caméra. ID = " << camID
+                  << " (" << camera.config.name << ", " << camera.config.source << ")" << std::endl;
+        return;
+    }
+
+    // Buffer de capture réutilisé : il est échangé avec l'image publiée
+    cv::Mat temp_frame;
+    std::string stage = "capture/" + camera.config.name;
+    const char* traceName = FrameTracer::intern(stage);
+
+    while (running) {
+        // Les deux buffers échangés sont alloués aux deux premières images
+        FramePool::Frame poolFrame(stage, 2);
+        int64_t traceStart = FrameTracer::now();
+        if (!source->read(temp_frame) || temp_frame.empty()) { // Capture une nouvelle image
+            // Source en erreur : pas d'attente active
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        int64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+
+        uint64_t seq;
+        {
+            std::lock_guard<std::mutex> lock(camera.frameMutex);
+            cv::swap(camera.frame, temp_frame);
+            seq = ++camera.seq;
+            camera.timestamp = timestamp;
+        }
+        FrameTracer::instance().record(traceName, seq, traceStart, FrameTracer::now());
+
+        // Seul ce thread remplace camera.frame : la lecture sans verrou est sûre ici
+        {
+            std::lock_guard<std::mutex> lock(observersMutex);
+            for (auto& observer : observers) observer.second(camID, seq, timestamp, camera.frame);
+        }
+    }
+}
+
+int CaptureManager::getNbCameras() const {
+    return (int)cameras.size();
+}
+
+const CameraConfig& CaptureManager::getCamera(int id) const {
+    return cameras[id]->config;
+}
+
+const std::vector<StereoPairConfig>& CaptureManager::getPairs() const {
+    return pairs;
+}
+
+// Copie de l'image courante dans un buffer persistant de l'appelant
+bool CaptureManager::copyFrameById(int id, cv::Mat& frame, FrameInfo* info) {
+    std::lock_guard<std::mutex> lock(cameras[id]->frameMutex);
+    if (cameras[id]->frame.empty()) return false;
+    cameras[id]->frame.copyTo(frame);
+    if (info != nullptr) {
+        info->seq = cameras[id]->seq;
+        info->timestamp = cameras[id]->timestamp;
+    }
+    return true;
+}
+
+int CaptureManager::addFrameObserver(const FrameObserver& observer) {
+    std::lock_guard<std::mutex> lock(observersMutex);
+    observers[nextObserver] = observer;
+    return nextObserver++;
+}
+
+// Au retour, l'observateur n'est plus appelé par aucun thread de capture
+void CaptureManager::removeFrameObserver(int handle) {
+    std::lock_guard<std::mutex> lock(observersMutex);
+    observers.erase(handle);
+}
+
+std::string CaptureManager::toJson() const {
+    std::ostringstream json;
+
+    json << "{\"cameras\":[";
+    for (size_t i = 0 ; i < cameras.size() ; i++) {
+        const CameraConfig& config = cameras[i]->config;
+        if (i > 0) json << ",";
+        json << "{\"id\":" << i
+             << ",\"name\":\"" << config.name << "\""
+             << ",\"device\":" << config.device
+             << ",\"source\":\"" << config.source << "\""
+             << ",\"width\":" << config.width
+             << ",\"height\":" << config.height
+             << ",\"fps\":" << config.fps
+             << ",\"stream\":\"/video" << (i + 1) << "\"}";
+    }
+
+    json << "],\"pairs\":[";
+    for (size_t i = 0 ; i < pairs.size() ; i++) {
+        if (i > 0) json << ",";
+        json << "{\"name\":\"" << pairs[i].name << "\""
+             << ",\"left\":" << pairs[i].left
+             << ",\"right\":" << pairs[i].right
+             << ",\"prefix\":\"/" << pairs[i].name << "/\"}";
+    }
+    json << "]}";
+
+    return json.str();
+}
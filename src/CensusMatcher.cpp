@@ -0,0 +1,279 @@
+#include "CensusMatcher.hpp"
+#include "FramePool.hpp"
+
+#include <opencv2/core/hal/intrin.hpp>
+
+CensusMatcher::CensusMatcher(int numDisparities, int windowSize) {
+    // Le nombre de disparités doit être un multiple de 16 (comme StereoBM)
+    this->numDisparities = std::max(16, (numDisparities + 15) / 16 * 16);
+
+    // Fenêtre impaire, bornée pour que les coûts tiennent sur 16 bits
+    windowSize = std::min(std::max(windowSize, 3), 51);
+    this->windowSize = windowSize | 1;
+}
+
+int CensusMatcher::getNumDisparities() const {
+    return numDisparities;
+}
+
+int CensusMatcher::getWindowSize() const {
+    return windowSize;
+}
+
+// Transformée de census : le bit k vaut 1 si le k-ième voisin est plus sombre que le centre
+void CensusMatcher::censusTransform(const cv::Mat& src, cv::Mat planes[CENSUS_PLANES]) {
+    const int R = CENSUS_RADIUS;
+
+    for (int p = 0 ; p < CENSUS_PLANES ; p++) {
+        if (planes[p].size() != src.size() || planes[p].type() != CV_8UC1) {
+            FramePool::ensure(planes[p], src.size(), CV_8UC1);
+            planes[p].setTo(0); // Les bords restent à zéro
+        }
+    }
+
+    cv::parallel_for_(cv::Range(R, src.rows - R), [&](const cv::Range& range) {
+        for (int y = range.start ; y < range.end ; y++) {
+            const uchar* rows[2 * R + 1];
+            for (int dy = -R ; dy <= R ; dy++) rows[dy + R] = src.ptr<uchar>(y + dy);
+            uchar* out[CENSUS_PLANES];
+            for (int p = 0 ; p < CENSUS_PLANES ; p++) out[p] = planes[p].ptr<uchar>(y);
+
+            int x = R;
+#if CV_SIMD
+            const int lanes = cv::v_uint8::nlanes;
+            for ( ; x + lanes <= src.cols - R ; x += lanes) {
+                cv::v_uint8 center = cv::vx_load(rows[R] + x);
+                cv::v_uint8 bits[CENSUS_PLANES] = {cv::vx_setzero_u8(), cv::vx_setzero_u8(), cv::vx_setzero_u8()};
+                int k = 0;
+                for (int dy = 0 ; dy <= 2 * R ; dy++) {
+                    for (int dx = -R ; dx <= R ; dx++) {
+                        if (dy == R && dx == 0) continue;
+                        cv::v_uint8 neighbour = cv::vx_load(rows[dy] + x + dx);
+                        bits[k / 8] = bits[k / 8] | ((neighbour < center) & cv::vx_setall_u8((uchar)(1 << (k % 8))));
+                        k++;
+                    }
+                }
+                for (int p = 0 ; p < CENSUS_PLANES ; p++) cv::v_store(out[p] + x, bits[p]);
+            }
+#endif
+            for ( ; x < src.cols - R ; x++) {
+                uchar center = rows[R][x];
+                uchar bits[CENSUS_PLANES] = {0, 0, 0};
+                int k = 0;
+                for (int dy = 0 ; dy <= 2 * R ; dy++) {
+                    for (int dx = -R ; dx <= R ; dx++) {
+                        if (dy == R && dx == 0) continue;
+                        if (rows[dy][x + dx] < center) bits[k / 8] |= (uchar)(1 << (k % 8));
+                        k++;
+                    }
+                }
+                for (int p = 0 ; p < CENSUS_PLANES ; p++) out[p][x] = bits[p];
+            }
+        }
+    });
+}
+
+// Appariement d'une bande de lignes.
+// Les coûts sont rangés par disparité (une ligne de coûts contiguë en x par
+// disparité) et agrégés verticalement de façon glissante, ce qui garde le
+// volume de coûts de la bande dans le cache.
+void CensusMatcher::matchStripe(int stripe, int nbStripes, cv::Mat& disparity) {
+    const int W = disparity.cols;
+    const int H = disparity.rows;
+    const int D = numDisparities;
+    const int R = windowSize / 2;
+    const int y0 = H * stripe / nbStripes;
+    const int y1 = H * (stripe + 1) / nbStripes;
+    if (y0 >= y1) return;
+
+    // Somme verticale des coûts, une ligne par disparité, complétée de R zéros de chaque côté
+    cv::Mat& vsum = costBuffers[stripe];
+    FramePool::ensure(vsum, cv::Size(W + 2 * R, D), CV_16UC1);
+    vsum.setTo(0);
+
+    // Lignes de travail : Hamming, coût minimal et meilleure disparité
+    cv::Mat& rows = rowBuffers[stripe];
+    FramePool::ensure(rows, cv::Size(W, 3), CV_16UC1);
+    uchar* ham = rows.ptr<uchar>(0);
+    ushort* minCost = rows.ptr<ushort>(1);
+    ushort* bestDisp = rows.ptr<ushort>(2);
+
+    // Ajoute (ou retire) la distance de Hamming d'une ligne à la somme verticale
+    auto accumulateRow = [&](int y, bool add) {
+        const uchar* l[CENSUS_PLANES];
+        const uchar* r[CENSUS_PLANES];
+        for (int p = 0 ; p < CENSUS_PLANES ; p++) {
+            l[p] = leftCensus[p].ptr<uchar>(y);
+            r[p] = rightCensus[p].ptr<uchar>(y);
+        }
+
+        for (int d = 0 ; d < D ; d++) {
+            // Hamming entre le pixel gauche x et le pixel droit x - d
+            int x = 0;
+            for ( ; x < std::min(d, W) ; x++) ham[x] = CENSUS_BITS;
+#if CV_SIMD
+            const int lanes8 = cv::v_uint8::nlanes;
+            for ( ; x + lanes8 <= W ; x += lanes8) {
+                cv::v_uint8 h = cv::v_popcount(cv::vx_load(l[0] + x) ^ cv::vx_load(r[0] + x - d));
+                for (int p = 1 ; p < CENSUS_PLANES ; p++) {
+                    h = h + cv::v_popcount(cv::vx_load(l[p] + x) ^ cv::vx_load(r[p] + x - d));
+                }
+                cv::v_store(ham + x, h);
+            }
+#endif
+            for ( ; x < W ; x++) {
+                int h = 0;
+                for (int p = 0 ; p < CENSUS_PLANES ; p++) h += __builtin_popcount(l[p][x] ^ r[p][x - d]);
+                ham[x] = (uchar)h;
+            }
+
+            ushort* v = vsum.ptr<ushort>(d) + R;
+            x = 0;
+#if CV_SIMD
+            const int lanes16 = cv::v_uint16::nlanes;
+            for ( ; x + 2 * lanes16 <= W ; x += 2 * lanes16) {
+                cv::v_uint16 h0, h1;
+                cv::v_expand(cv::vx_load(ham + x), h0, h1);
+                if (add) {
+                    cv::v_store(v + x, cv::vx_load(v + x) + h0);
+                    cv::v_store(v + x + lanes16, cv::vx_load(v + x + lanes16) + h1);
+                } else {
+                    cv::v_store(v + x, cv::vx_load(v + x) - h0);
+                    cv::v_store(v + x + lanes16, cv::vx_load(v + x + lanes16) - h1);
+                }
+            }
+#endif
+            for ( ; x < W ; x++) {
+                v[x] = add ? (ushort)(v[x] + ham[x]) : (ushort)(v[x] - ham[x]);
+            }
+        }
+    };
+
+    // Fenêtre initiale centrée sur la première ligne de la bande
+    for (int y = std::max(0, y0 - R) ; y <= std::min(H - 1, y0 + R) ; y++) accumulateRow(y, true);
+
+    for (int y = y0 ; y < y1 ; y++) {
+        // Fenêtre glissante : une ligne entre, une ligne sort
+        if (y > y0) {
+            if (y + R < H) accumulateRow(y + R, true);
+            if (y - R - 1 >= 0) accumulateRow(y - R - 1, false);
+        }
+
+        // Agrégation horizontale puis sélection du coût minimal (winner takes all)
+        std::fill(minCost, minCost + W, (ushort)0xFFFF);
+        std::fill(bestDisp, bestDisp + W, (ushort)0);
+
+        for (int d = 0 ; d < D ; d++) {
+            const ushort* v = vsum.ptr<ushort>(d) + R;
+            int x = 0;
+#if CV_SIMD
+            const int lanes16 = cv::v_uint16::nlanes;
+            cv::v_uint16 vd = cv::vx_setall_u16((ushort)d);
+            for ( ; x + lanes16 <= W ; x += lanes16) {
+                cv::v_uint16 cost = cv::vx_load(v + x - R);
+                for (int k = -R + 1 ; k <= R ; k++) cost = cost + cv::vx_load(v + x + k);
+                cv::v_uint16 current = cv::vx_load(minCost + x);
+                cv::v_uint16 better = cost < current;
+                cv::v_store(minCost + x, cv::v_min(cost, current));
+                cv::v_store(bestDisp + x, cv::v_select(better, vd, cv::vx_load(bestDisp + x)));
+            }
+#endif
+            for ( ; x < W ; x++) {
+                int cost = 0;
+                for (int k = -R ; k <= R ; k++) cost += v[x + k];
+                if (cost < minCost[x]) {
+                    minCost[x] = (ushort)cost;
+                    bestDisp[x] = (ushort)d;
+                }
+            }
+        }
+
+        short* out = disparity.ptr<short>(y);
+        for (int x = 0 ; x < W ; x++) {
+            out[x] = x < D ? (short)-16 : (short)(bestDisp[x] * 16);
+        }
+    }
+}
+
+// Calcul de la disparité, en parallèle par bandes de lignes
+void CensusMatcher::compute(const cv::Mat& left, const cv::Mat& right, cv::Mat& disparity) {
+    CV_Assert(left.type() == CV_8UC1 && right.type() == CV_8UC1 && left.size() == right.size());
+
+    censusTransform(left, leftCensus);
+    censusTransform(right, rightCensus);
+
+    FramePool::ensure(disparity, left.size(), CV_16S);
+
+    // Une bande par thread, avec des buffers propres à chaque bande
+    int nbStripes = std::max(1, std::min(cv::getNumThreads(), left.rows));
+    if ((int)costBuffers.size() != nbStripes) {
+        costBuffers.resize(nbStripes);
+        rowBuffers.resize(nbStripes);
+    }
+
+    // Les buffers des bandes sont créés dans les threads d'OpenCV : comptés pour l'image en cours
+    FramePool::Counter* frameCounter = FramePool::currentCounter();
+    cv::parallel_for_(cv::Range(0, nbStripes), [&](const cv::Range& range) {
+        FramePool::Scope scope(frameCounter);
+        for (int stripe = range.start ; stripe < range.end ; stripe++) {
+            matchStripe(stripe, nbStripes, disparity);
+        }
+    }, nbStripes);
+}
+
+// Version directe, sans agrégation glissante ni vectorisation
+void CensusMatcher::computeReference(const cv::Mat& left, const cv::Mat& right, cv::Mat& disparity) const {
+    CV_Assert(left.type() == CV_8UC1 && right.type() == CV_8UC1 && left.size() == right.size());
+
+    const int W = left.cols;
+    const int H = left.rows;
+    const int D = numDisparities;
+    const int R = windowSize / 2;
+    const int CR = CENSUS_RADIUS;
+
+    // Descripteur census 24 bits de chaque pixel (0 sur les bords)
+    auto census = [&](const cv::Mat& img) {
+        cv::Mat desc(img.size(), CV_32SC1, cv::Scalar(0));
+        for (int y = CR ; y < H - CR ; y++) {
+            for (int x = CR ; x < W - CR ; x++) {
+                int bits = 0, k = 0;
+                for (int dy = -CR ; dy <= CR ; dy++) {
+                    for (int dx = -CR ; dx <= CR ; dx++) {
+                        if (dy == 0 && dx == 0) continue;
+                        if (img.at<uchar>(y + dy, x + dx) < img.at<uchar>(y, x)) bits |= 1 << k;
+                        k++;
+                    }
+                }
+                desc.at<int>(y, x) = bits;
+            }
+        }
+        return desc;
+    };
+
+    cv::Mat leftDesc = census(left);
+    cv::Mat rightDesc = census(right);
+    disparity.create(left.size(), CV_16S);
+
+    for (int y = 0 ; y < H ; y++) {
+        for (int x = 0 ; x < W ; x++) {
+            int bestCost = 0xFFFF, best = 0;
+            for (int d = 0 ; d < D ; d++) {
+                int cost = 0;
+                for (int yy = std::max(0, y - R) ; yy <= std::min(H - 1, y + R) ; yy++) {
+                    for (int xx = std::max(0, x - R) ; xx <= std::min(W - 1, x + R) ; xx++) {
+                        if (xx < d) {
+                            cost += CENSUS_BITS;
+                        } else {
+                            cost += __builtin_popcount(leftDesc.at<int>(yy, xx) ^ rightDesc.at<int>(yy, xx - d));
+                        }
+                    }
+                }
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = d;
+                }
+            }
+            disparity.at<short>(y, x) = x < D ? (short)-16 : (short)(best * 16);
+        }
+    }
+}
@@ -1,36 +1,143 @@
 #include "DisparityController.hpp"
 
-std::mutex DisparityController::disparityMutex;
-std::thread DisparityController::disThread;
-cv::Mat DisparityController::disparity;
-bool DisparityController::running;
-IndexController* DisparityController::indexCtrl;
-
-DisparityController::DisparityController(struct mg_context* ctx, IndexController* indexCtrl) {
-    this->indexCtrl = indexCtrl;
+#include <sstream>
+
+// Images en vol dans le pipeline : une par étage et une en attente
+static const int PIPELINE_JOBS = NB_PIPELINE_STAGES + 1;
+
+// Noms des étages pour les threads et /pipeline
+static const char* PIPELINE_STAGE_NAMES[NB_PIPELINE_STAGES] = {"rectify", "match", "obstacles", "publish"};
+
+// Moyenne glissante sur une vingtaine d'images
+static void updateAverage(std::atomic<long>& average, long micros) {
+    long previous = average.load(std::memory_order_relaxed);
+    average.store(previous == 0 ? micros : previous + (micros - previous) / 16, std::memory_order_relaxed);
+}
+
+static long elapsedMicros(std::chrono::steady_clock::time_point start) {
+    return (long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PipelineStageStats::record(long micros) {
+    frames++;
+    lastMicros = micros;
+    updateAverage(avgMicros, micros);
+}
+
+// Transmet un job à un étage et le réveille s'il dort
+void DisparityController::forward(SpscQueue<DisparityJob*>& queue, PipelineStage stage, DisparityJob* job) {
+    queue.push(job); // Jamais pleine : chaque file peut contenir tous les jobs
+    stageSignals[stage].notify();
+}
+
+// Prochain job de la file d'entrée d'un étage, qui dort tant qu'elle est vide ; false à l'arrêt
+bool DisparityController::nextJob(SpscQueue<DisparityJob*>& queue, PipelineStage stage, DisparityJob*& job) {
+    stageSignals[stage].wait([&]() { return !running || queue.size() > 0; });
+    return running && queue.pop(job);
+}
+
+DisparityController::DisparityController(struct mg_context* ctx, CaptureManager* captureManager,
+                                         const StereoPairConfig& pair, bool legacyRoutes)
+    : disparityDemand(pair.name + "/disparity"),
+      freeJobs(PIPELINE_JOBS), rectifiedJobs(PIPELINE_JOBS), matchedJobs(PIPELINE_JOBS),
+      measuredJobs(PIPELINE_JOBS), obstaclesDemand(pair.name + "/obstacles") {
+    this->captureManager = captureManager;
+    this->pair = pair;
     running = true;
+    engine = ENGINE_BM;
+
+    // Taille des images de la caméra gauche de la paire
+    const CameraConfig& left = captureManager->getCamera(pair.left);
+    imageSize = cv::Size(left.width, left.height);
+    calibrationFile = pair.dataDir + "/calibration/stereo_calib.yml";
+    calibrationBundle = pair.dataDir + "/calibration/stereo_calib.bin";
 
-    // Lance les threads de capture vidéo
-    disThread = std::thread(DisparityController::disparityThread);
+    // Les jobs sont tous libres au départ
+    latencyMicros = 0;
+    obstaclesSeq = 0;
+    newFrames = false;
+    for (int i = 0 ; i < PIPELINE_JOBS ; i++) {
+        jobs.emplace_back(new DisparityJob());
+        freeJobs.push(jobs.back().get());
+    }
+
+    // Lance les threads de calcul et de rechargement de la calibration
+    reloadRequested = false;
+    reloadThread = TaskScheduler::instance().spawn(pair.name + "/calibration-reload", STAGE_SERVICE,
+                                                   [this]() { calibrationReloadThread(); });
+    recorder.reset(new StereoRecorder(captureManager, pair));
+    if (pair.sharedMemory) {
+        sharedExport.reset(new SharedFrameExport(captureManager, pair));
+        sharedSubscription.reset(new StreamDemand::Subscription(disparityDemand));
+    }
+
+    // Encodage JPEG de la disparité publiée, une fois par image pour tous les clients
+    encodeStream = EncodeService::instance().addStream(pair.name + "/disparity",
+        [this](cv::Mat& frame, FrameInfo& info) {
+            std::lock_guard<std::mutex> lock(disparityMutex);
+            if (disparity.empty()) return false;
+            disparity.copyTo(frame);
+            info = disparityInfo;
+            return true;
+        });
+
+    // Les caméras de la paire réveillent la rectification à chaque nouvelle image
+    frameObserver = captureManager->addFrameObserver([this](int camID, uint64_t, int64_t, const cv::Mat&) {
+        if (camID != this->pair.left && camID != this->pair.right) return;
+        newFrames = true;
+        stageSignals[PIPELINE_RECTIFY].notify();
+    });
+
+    std::function<void()> stages[NB_PIPELINE_STAGES] = {
+        [this]() { rectifyStage(); }, [this]() { matchStage(); },
+        [this]() { obstacleStage(); }, [this]() { publishStage(); }
+    };
+    for (int i = 0 ; i < NB_PIPELINE_STAGES ; i++) {
+        stageThreads[i] = TaskScheduler::instance().spawn(pair.name + "/" + PIPELINE_STAGE_NAMES[i], STAGE_COMPUTE, stages[i]);
+    }
 
-    // Configure les handlers
+    // Configure les handlers, sous /<paire>/ et à la racine pour la première paire
     if(ctx == nullptr) {
         std::cerr << "Erreur : impossible de démarrer le serveur HTTP." << std::endl;
         running = false;
     } else {
-        mg_set_request_handler(ctx, "/disparityStream", streamHandler, nullptr);
-        mg_set_request_handler(ctx, "/disparity", rootHandler, nullptr);
+        std::vector<std::string> prefixes = {"/" + pair.name};
+        if (legacyRoutes) prefixes.push_back("");
+
+        for (const std::string& prefix : prefixes) {
+            mg_set_request_handler(ctx, (prefix + "/disparityStream").c_str(), streamHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/disparityEngine").c_str(), engineHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/disparityBenchmark").c_str(), benchmarkHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/pipeline").c_str(), pipelineHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/recording").c_str(), recordingHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/obstacles").c_str(), obstaclesHandler, this);
+            mg_set_request_handler(ctx, (prefix + "/disparity").c_str(), rootHandler, this);
+        }
         running = true;
     }
 }
 
-DisparityController::~DisparityController() {
+// Réveille les threads de calcul et les handlers en attente (obstacles, flux)
+void DisparityController::stop() {
     running = false;
-    disThread.join();
+    reloadCond.notify_all();
+    obstaclesCond.notify_all();
+    for (QueueSignal& signal : stageSignals) signal.wakeAll();
+}
+
+DisparityController::~DisparityController() {
+    stop();
+    captureManager->removeFrameObserver(frameObserver);
+    EncodeService::instance().removeStream(encodeStream);
+    for (std::thread& thread : stageThreads) thread.join();
+    reloadThread.join();
 }
 
 // Gestionnaire de la requête, affiche le flux MJPEG
 int DisparityController::streamHandler(struct mg_connection *conn, void *param) {
+    DisparityController *ctrl = (DisparityController *)(param);
+    StreamDemand::Subscription subscription(ctrl->disparityDemand);
+    TaskScheduler::Adoption adoption("http", STAGE_ENCODE);
 
     // En-têtes pour le flux MJPEG
     mg_printf(conn,
@@ -39,114 +146,562 @@ int DisparityController::streamHandler(struct mg_connection *conn, void *param)
               "Cache-Control: no-cache\r\n"
               "\r\n");
 
+    EncodeService::Subscription encodeSubscription(ctrl->encodeStream);
+    const char* writeTrace = FrameTracer::intern("write/" + ctrl->pair.name + "/disparity");
+    uint64_t lastSeq = 0;
+
+    while (ctrl->running) {
+        std::shared_ptr<const EncodedFrame> frame = EncodeService::instance().waitForFrame(ctrl->encodeStream, lastSeq, 500);
+        if (!frame) continue;
+        lastSeq = frame->seq;
+
+        FrameTracer::Span span(writeTrace, frame->seq);
+        mg_printf(conn,
+                  "--frame\r\n"
+                  "Content-Type: image/jpeg\r\n"
+                  "X-Frame-Seq: %llu\r\n"
+                  "X-Capture-Timestamp: %lld\r\n"
+                  "Content-Length: %lu\r\n\r\n",
+                  (unsigned long long)frame->seq, (long long)frame->timestamp, frame->data.size());
+        // Le client s'est déconnecté
+        if (mg_write(conn, frame->data.data(), frame->data.size()) <= 0) break;
+        mg_printf(conn, "\r\n");
+    }
+
+    return 200; // Réponse HTTP réussie
+}
+
+// Demande de rechargement de la calibration (après une recalibration)
+void DisparityController::requestCalibrationReload() {
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        reloadRequested = true;
+    }
+    reloadCond.notify_all();
+}
+
+// Contexte de rectification courant
+std::shared_ptr<const RectificationContext> DisparityController::getRectification() {
+    return std::atomic_load(&rectification);
+}
+
+// Thread qui reconstruit le contexte de rectification en arrière-plan quand
+// la calibration change, puis l'échange avec celui du thread de disparité
+void DisparityController::calibrationReloadThread() {
+    fs::file_time_type loadedTime;
+    bool loaded = false;
+
+    while (running) {
+        bool forced = false;
+
+        // Vérification du fichier toutes les secondes, ou immédiatement sur demande
+        if (loaded) {
+            std::unique_lock<std::mutex> lock(reloadMutex);
+            reloadCond.wait_for(lock, std::chrono::seconds(1), [this] { return reloadRequested || !running; });
+            forced = reloadRequested;
+            reloadRequested = false;
+        }
+        if (!running) break;
+
+        std::error_code yamlError, bundleError;
+        fs::file_time_type yamlTime = fs::last_write_time(calibrationFile, yamlError);
+        fs::file_time_type bundleTime = fs::last_write_time(calibrationBundle, bundleError);
+        if (yamlError && bundleError) {
+            if (!loaded) std::cerr << "Erreur : pas de calibration dans " << calibrationFile << std::endl;
+            loaded = true;
+            continue;
+        }
+
+        fs::file_time_type fileTime = yamlError ? bundleTime : (bundleError ? yamlTime : std::max(yamlTime, bundleTime));
+        if (!forced && fileTime == loadedTime) continue;
+        loadedTime = fileTime;
+        loaded = true;
+
+        // Le bundle binaire est chargé sans analyse ni calcul ; le YAML ne sert
+        // que s'il n'y a pas de bundle valide ou s'il a été modifié à la main depuis
+        std::shared_ptr<const RectificationContext> ctx;
+        std::string source = calibrationBundle;
+        if (!bundleError && (yamlError || bundleTime >= yamlTime)) {
+            ctx = RectificationContext::fromBundle(calibrationBundle, imageSize);
+        }
+        if (!ctx && !yamlError) {
+            source = calibrationFile;
+            ctx = RectificationContext::fromFile(calibrationFile, imageSize);
+        }
+        if (!ctx) {
+            std::cerr << "Erreur : calibration invalide, la précédente est conservée." << std::endl;
+            continue;
+        }
+
+        std::atomic_store(&rectification, ctx);
+        std::cout << "Calibration chargée depuis " << source << std::endl;
+    }
+}
+
+// Étage 1 : copie des images et rectification, au rythme de la capture
+void DisparityController::rectifyStage() {
+    // Buffers de travail conservés d'une image à l'autre
+    cv::Mat frame1, frame2, gray1, gray2;
+    FrameInfo info1, info2;
+    std::string stage = pair.name + "/" + PIPELINE_STAGE_NAMES[PIPELINE_RECTIFY];
+    const char* copyTrace = FrameTracer::intern(pair.name + "/copy");
+    const char* rectifyTrace = FrameTracer::intern(stage);
+    DisparityJob* job = nullptr;
+
+    // Les tâches tournent sur le pool de calcul : leurs allocations comptent pour l'image
+    FramePool::Counter* frameCounter = nullptr;
+    std::vector<std::function<void()>> rectifyTasks = {
+        [&]() {
+            FramePool::Scope scope(frameCounter);
+            cv::cvtColor(frame1, gray1, cv::COLOR_BGR2GRAY);
+            cv::remap(gray1, job->rectified1, job->ctx->map1xy, job->ctx->map1frac, cv::INTER_LINEAR);
+        },
+        [&]() {
+            FramePool::Scope scope(frameCounter);
+            cv::cvtColor(frame2, gray2, cv::COLOR_BGR2GRAY);
+            cv::remap(gray2, job->rectified2, job->ctx->map2xy, job->ctx->map2frac, cv::INTER_LINEAR);
+        }
+    };
+
     while (running) {
-        std::vector<uchar> buf;
+        // Pas de calcul tant que personne ne regarde la disparité
+        if(!disparityDemand.waitForSubscribers(running)) continue;
 
+        // Le contexte est fixé pour toute l'image, même si un rechargement a lieu entre-temps
+        std::shared_ptr<const RectificationContext> ctx = getRectification();
+        if(!ctx) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        // Dort tant que tous les jobs sont en aval (les étages suivants sont le goulot)
+        // ou qu'aucune caméra de la paire n'a produit de nouvelle image
+        stageSignals[PIPELINE_RECTIFY].wait([&]() {
+            return !running || ((job != nullptr || freeJobs.size() > 0) && newFrames);
+        });
+        if (!running) break;
+        if (job == nullptr) freeJobs.pop(job);
+        newFrames = false;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        // Chaque job alloue ses buffers à sa première utilisation, ensuite plus rien
+        FramePool::Frame poolFrame(stage, 2 * PIPELINE_JOBS);
+        frameCounter = FramePool::currentCounter();
         {
-            std::lock_guard<std::mutex> lock(disparityMutex);
-            if (!disparity.empty()) {
-                cv::imencode(".jpg", disparity, buf);
+            // Attente des verrous des caméras comprise
+            FrameTracer::Span span(copyTrace, 0);
+            if(!captureManager->copyFrameById(pair.left, frame1, &info1) ||
+               !captureManager->copyFrameById(pair.right, frame2, &info2)) continue;
+            span.setSeq(info1.seq);
+        }
+        FrameTracer::Span span(rectifyTrace, info1.seq);
+
+        job->ctx = ctx;
+        FramePool::ensure(gray1, frame1.size(), CV_8UC1);
+        FramePool::ensure(gray2, frame2.size(), CV_8UC1);
+        FramePool::ensure(job->rectified1, ctx->map1xy.size(), CV_8UC1);
+        FramePool::ensure(job->rectified2, ctx->map2xy.size(), CV_8UC1);
+
+        // Rectification des deux images en parallèle sur le pool de calcul
+        TaskScheduler::instance().runAll(rectifyTasks);
+
+        job->frame = info1;
+        job->start = start;
+        job->dropped = false;
+        forward(rectifiedJobs, PIPELINE_MATCH, job);
+        job = nullptr;
+        stageStats[PIPELINE_RECTIFY].record(elapsedMicros(start));
+    }
+}
+
+// Étage 2 : mise en correspondance de la paire rectifiée la plus récente
+void DisparityController::matchStage() {
+    cv::Ptr<cv::StereoBM> stereo = cv::StereoBM::create(16, 15); // Paramètres ajustables
+    CensusMatcher census(16, 9);
+    std::string stage = pair.name + "/" + PIPELINE_STAGE_NAMES[PIPELINE_MATCH];
+    const char* traceName = FrameTracer::intern(stage);
+
+    while (running) {
+        DisparityJob* job;
+        if (!nextJob(rectifiedJobs, PIPELINE_MATCH, job)) continue;
+
+        // En surcharge, les images en attente sont périmées : seule la dernière est
+        // traitée, les autres sont transmises marquées pour être recyclées
+        DisparityJob* newer;
+        while (rectifiedJobs.pop(newer)) {
+            job->dropped = true;
+            forward(matchedJobs, PIPELINE_OBSTACLES, job);
+            stageStats[PIPELINE_MATCH].dropped++;
+            job = newer;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        FramePool::Frame poolFrame(stage, 2 * PIPELINE_JOBS);
+        FramePool::ensure(job->disparity16, job->rectified1.size(), CV_16S);
+        {
+            FrameTracer::Span span(traceName, job->frame.seq);
+            if (engine == ENGINE_CENSUS) {
+                census.compute(job->rectified1, job->rectified2, job->disparity16);
+            } else {
+                stereo->compute(job->rectified1, job->rectified2, job->disparity16);
             }
         }
+        forward(matchedJobs, PIPELINE_OBSTACLES, job);
+        stageStats[PIPELINE_MATCH].record(elapsedMicros(start));
+    }
+}
 
-        if (!buf.empty()) {
-            mg_printf(conn,
-                      "--frame\r\n"
-                      "Content-Type: image/jpeg\r\n"
-                      "Content-Length: %lu\r\n\r\n",
-                      buf.size());
-            mg_write(conn, buf.data(), buf.size());
-            mg_printf(conn, "\r\n");
+// Étage 3 : profil d'obstacles et grille d'occupation, publiés à chaque image
+void DisparityController::obstacleStage() {
+    ObstacleMap map(pair.obstacleMaxDistance, pair.obstacleMinHeight, pair.obstacleMaxHeight);
+    ObstacleSummary summary;
+    std::string json;
+    std::string stage = pair.name + "/" + PIPELINE_STAGE_NAMES[PIPELINE_OBSTACLES];
+    const char* traceName = FrameTracer::intern(stage);
+
+    while (running) {
+        DisparityJob* job;
+        if (!nextJob(matchedJobs, PIPELINE_OBSTACLES, job)) continue;
+
+        // Seule la disparité la plus récente est analysée, les autres suivent marquées
+        DisparityJob* newer;
+        while (matchedJobs.pop(newer)) {
+            if (!job->dropped) {
+                job->dropped = true;
+                stageStats[PIPELINE_OBSTACLES].dropped++;
+            }
+            forward(measuredJobs, PIPELINE_PUBLISH, job);
+            job = newer;
+        }
+
+        // Rien à faire si personne n'attend les obstacles
+        if (job->dropped || !obstaclesDemand.poll()) {
+            forward(measuredJobs, PIPELINE_PUBLISH, job);
+            continue;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(33)); // ~30 FPS
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        {
+            FrameTracer::Span span(traceName, job->frame.seq);
+            map.compute(job->disparity16, job->ctx->Q, summary);
+            summary.seq = job->frame.seq;
+            summary.timestamp = job->frame.timestamp;
+            json = map.toJson(summary);
+        }
+        forward(measuredJobs, PIPELINE_PUBLISH, job);
+
+        {
+            std::lock_guard<std::mutex> lock(obstaclesMutex);
+            obstaclesJson.swap(json);
+            obstaclesSeq = summary.seq;
+        }
+        obstaclesCond.notify_all();
+        stageStats[PIPELINE_OBSTACLES].record(elapsedMicros(start));
     }
+}
 
-    return 200; // Réponse HTTP réussie
+// Étage 4 : conversion en 8 bits et publication pour les flux MJPEG
+void DisparityController::publishStage() {
+    std::string stage = pair.name + "/" + PIPELINE_STAGE_NAMES[PIPELINE_PUBLISH];
+    const char* traceName = FrameTracer::intern(stage);
+
+    while (running) {
+        DisparityJob* job;
+        if (!nextJob(measuredJobs, PIPELINE_PUBLISH, job)) continue;
+
+        // Seule la disparité la plus récente est publiée, les autres jobs sont recyclés
+        DisparityJob* newer;
+        while (measuredJobs.pop(newer)) {
+            if (!job->dropped) stageStats[PIPELINE_PUBLISH].dropped++;
+            forward(freeJobs, PIPELINE_RECTIFY, job);
+            job = newer;
+        }
+        if (job->dropped) {
+            forward(freeJobs, PIPELINE_RECTIFY, job);
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        // Le buffer publié tourne entre les jobs : il faut un tour complet avant le régime établi
+        FramePool::Frame poolFrame(stage, 2 * PIPELINE_JOBS);
+        int64_t traceStart = FrameTracer::now();
+
+        // La conversion en 8 bits se fait dans le buffer du job pour ne pas réallouer
+        FramePool::ensure(job->disparity8, job->disparity16.size(), CV_8U);
+        cv::normalize(job->disparity16, job->disparity8, 0, 255, cv::NORM_MINMAX, CV_8U);
+
+        {
+            std::lock_guard<std::mutex> lock(disparityMutex);
+            cv::swap(disparity, job->disparity8);
+            disparityInfo = job->frame;
+        }
+        EncodeService::instance().notify(encodeStream);
+        FrameTracer::instance().record(traceName, job->frame.seq, traceStart, FrameTracer::now());
+
+        // Horodatée comme l'image gauche dont elle est issue
+        if (recorder->isRecording()) {
+            recorder->pushDisparity(job->frame.seq, job->frame.timestamp, job->disparity16);
+        }
+        if (sharedExport) {
+            sharedExport->pushDisparity(job->frame.seq, job->frame.timestamp, job->disparity16);
+        }
+        stageStats[PIPELINE_PUBLISH].record(elapsedMicros(start));
+        updateAverage(latencyMicros, elapsedMicros(job->start));
+        job->ctx.reset();
+        forward(freeJobs, PIPELINE_RECTIFY, job);
+    }
 }
 
-// Chargement des paramétres de calibration
-void DisparityController::loadCalibration(const std::string& filename,
-                     cv::Mat& cameraMatrix1, cv::Mat& distCoeffs1,
-                     cv::Mat& cameraMatrix2, cv::Mat& distCoeffs2,
-                     cv::Mat& R, cv::Mat& T) {
-    cv::FileStorage fs(filename, cv::FileStorage::READ);
-    fs["cameraMatrix1"] >> cameraMatrix1;
-    fs["distCoeffs1"] >> distCoeffs1;
-    fs["cameraMatrix2"] >> cameraMatrix2;
-    fs["distCoeffs2"] >> distCoeffs2;
-    fs["R"] >> R;
-    fs["T"] >> T;
-    fs.release();
+// État du pipeline : profondeur des files et latence de chaque étage
+int DisparityController::pipelineHandler(struct mg_connection *conn, void *param) {
+    DisparityController *ctrl = (DisparityController *)(param);
+
+    // File en entrée de chaque étage ; la rectification attend un job libre
+    size_t depths[NB_PIPELINE_STAGES] = {
+        ctrl->freeJobs.size(), ctrl->rectifiedJobs.size(), ctrl->matchedJobs.size(), ctrl->measuredJobs.size()
+    };
+
+    std::ostringstream json;
+    json << "{\"pair\":\"" << ctrl->pair.name << "\",\"jobs\":" << PIPELINE_JOBS
+         << ",\"latency_ms\":" << ctrl->latencyMicros / 1000.0 << ",\"stages\":[";
+    for (int i = 0 ; i < NB_PIPELINE_STAGES ; i++) {
+        const PipelineStageStats& stats = ctrl->stageStats[i];
+        if (i > 0) json << ",";
+        json << "{\"name\":\"" << PIPELINE_STAGE_NAMES[i] << "\""
+             << ",\"queue\":" << depths[i]
+             << ",\"frames\":" << stats.frames
+             << ",\"dropped\":" << stats.dropped
+             << ",\"last_ms\":" << stats.lastMicros / 1000.0
+             << ",\"avg_ms\":" << stats.avgMicros / 1000.0 << "}";
+    }
+    json << "]";
+    if (ctrl->sharedExport) json << ",\"shared_memory\":" << ctrl->sharedExport->statusJson();
+    json << "}";
+
+    std::string body = json.str();
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              body.size());
+    mg_write(conn, body.data(), body.size());
+    return 200;
 }
 
-// Creation du flux de disparité
-void DisparityController::disparityThread(){
-    cv::Mat cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T;
-    loadCalibration("./data/calibration/stereo_calib.yml", cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T);
+// Enregistrement : /recording (état), /recording?action=start[&disparity=1], /recording?action=stop
+int DisparityController::recordingHandler(struct mg_connection *conn, void *param) {
+    DisparityController *ctrl = (DisparityController *)(param);
+    const struct mg_request_info *info = mg_get_request_info(conn);
+    char action[16] = "";
+    char withDisparity[8] = "";
 
-    cv::Mat R1, R2, P1, P2, Q;
-    cv::Size imageSize(640, 480);
+    if (info->query_string != nullptr) {
+        mg_get_var(info->query_string, strlen(info->query_string), "action", action, sizeof(action));
+        mg_get_var(info->query_string, strlen(info->query_string), "disparity", withDisparity, sizeof(withDisparity));
+    }
 
-    cv::stereoRectify(cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2,
-                      imageSize, R, T, R1, R2, P1, P2, Q);
+    if (strcmp(action, "start") == 0) {
+        // Un fichier par session, horodaté
+        char name[32];
+        time_t now = time(nullptr);
+        strftime(name, sizeof(name), "%Y%m%d-%H%M%S", localtime(&now));
+        std::string filename = ctrl->pair.dataDir + "/recordings/" + name + ".pvrec";
 
-    cv::Mat map1x, map1y, map2x, map2y;
-    cv::initUndistortRectifyMap(cameraMatrix1, distCoeffs1, R1, P1, imageSize, CV_32FC1, map1x, map1y);
-    cv::initUndistortRectifyMap(cameraMatrix2, distCoeffs2, R2, P2, imageSize, CV_32FC1, map2x, map2y);
+        if (!ctrl->recorder->start(filename, strcmp(withDisparity, "1") == 0)) {
+            mg_printf(conn,
+                      "HTTP/1.1 409 Conflict\r\n"
+                      "Content-Type: text/plain\r\n\r\n"
+                      "Recording already running or file not writable!");
+            return 409;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        ctrl->recorder->stop();
+    }
 
-    cv::Ptr<cv::StereoBM> stereo = cv::StereoBM::create(16, 15); // Paramètres ajustables
+    std::string json = ctrl->recorder->statusJson();
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
+    return 200;
+}
 
-    while (running) {
-        cv::Mat frame1, frame2, gray1, gray2, rectified1, rectified2, disparityTemp;
+// Choix du moteur de disparité : /disparityEngine?engine=bm|census
+int DisparityController::engineHandler(struct mg_connection *conn, void *param) {
+    DisparityController *ctrl = (DisparityController *)(param);
+    const struct mg_request_info *info = mg_get_request_info(conn);
+    char name[16] = "";
 
-        frame1 = indexCtrl->getFrameById(0);
-        frame2 = indexCtrl->getFrameById(1);
-        if(frame1.empty() || frame2.empty()) continue;
+    if (info->query_string != nullptr) {
+        mg_get_var(info->query_string, strlen(info->query_string), "engine", name, sizeof(name));
+    }
 
-        cv::cvtColor(frame1, gray1, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(frame2, gray2, cv::COLOR_BGR2GRAY);
+    if (strcmp(name, "census") == 0) {
+        ctrl->engine = ENGINE_CENSUS;
+    } else if (strcmp(name, "bm") == 0) {
+        ctrl->engine = ENGINE_BM;
+    } else {
+        mg_printf(conn,
+                  "HTTP/1.1 400 Bad Request\r\n"
+                  "Content-Type: text/plain\r\n\r\n"
+                  "Unknown engine!");
+        return 400;
+    }
 
-        cv::remap(gray1, rectified1, map1x, map1y, cv::INTER_LINEAR);
-        cv::remap(gray2, rectified2, map2x, map2y, cv::INTER_LINEAR);
+    std::cout << "Moteur de disparité (" << ctrl->pair.name << ") : " << name << std::endl;
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: text/plain\r\n\r\n"
+              "Success!");
+    return 200;
+}
 
-        // stereo->compute(gray1, gray2, disparityTemp);
-        stereo->compute(rectified1, rectified2, disparityTemp);
+// Obstacles : /obstacles (dernier résumé), /obstacles?after=N[&timeout=ms] (long-poll : résumé
+// d'une image plus récente que N, 204 si aucune), /obstacles?stream=1 (une ligne JSON par image)
+int DisparityController::obstaclesHandler(struct mg_connection *conn, void *param) {
+    DisparityController *ctrl = (DisparityController *)(param);
+    const struct mg_request_info *info = mg_get_request_info(conn);
+    char value[32] = "";
+    uint64_t after = 0;
+    int timeoutMs = 2000;
+    bool stream = false;
+
+    if (info->query_string != nullptr) {
+        size_t length = strlen(info->query_string);
+        if (mg_get_var(info->query_string, length, "after", value, sizeof(value)) > 0) {
+            after = strtoull(value, nullptr, 10);
+        }
+        if (mg_get_var(info->query_string, length, "timeout", value, sizeof(value)) > 0) {
+            timeoutMs = std::max(0, std::min(atoi(value), 30000));
+        }
+        if (mg_get_var(info->query_string, length, "stream", value, sizeof(value)) > 0) {
+            stream = strcmp(value, "1") == 0;
+        }
+    }
 
-        cv::normalize(disparityTemp, disparityTemp, 0, 255, cv::NORM_MINMAX, CV_8U);
+    // La disparité et les obstacles sont calculés tant qu'un client attend
+    StreamDemand::Subscription disparitySubscription(ctrl->disparityDemand);
+    StreamDemand::Subscription obstaclesSubscription(ctrl->obstaclesDemand);
+    TaskScheduler::Adoption adoption("http", STAGE_ENCODE);
 
+    std::string body;
+    if (!stream) {
         {
-            std::lock_guard<std::mutex> lock(disparityMutex);
-            disparity = disparityTemp.clone();
+            std::unique_lock<std::mutex> lock(ctrl->obstaclesMutex);
+            ctrl->obstaclesCond.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                         [&]() { return !ctrl->running || ctrl->obstaclesSeq > after; });
+            if (ctrl->obstaclesSeq > after) body = ctrl->obstaclesJson;
         }
+
+        if (body.empty()) {
+            mg_printf(conn,
+                      "HTTP/1.1 204 No Content\r\n"
+                      "Cache-Control: no-cache\r\n"
+                      "Content-Length: 0\r\n\r\n");
+            return 204;
+        }
+        mg_printf(conn,
+                  "HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/json\r\n"
+                  "Cache-Control: no-cache\r\n"
+                  "Content-Length: %zu\r\n\r\n",
+                  body.size());
+        mg_write(conn, body.data(), body.size());
+        return 200;
     }
+
+    // Flux : un résumé par ligne, dès qu'il est calculé
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/x-ndjson\r\n"
+              "Cache-Control: no-cache\r\n"
+              "\r\n");
+    while (ctrl->running) {
+        {
+            std::unique_lock<std::mutex> lock(ctrl->obstaclesMutex);
+            ctrl->obstaclesCond.wait_for(lock, std::chrono::seconds(1),
+                                         [&]() { return !ctrl->running || ctrl->obstaclesSeq > after; });
+            if (ctrl->obstaclesSeq <= after) continue;
+            body = ctrl->obstaclesJson;
+            after = ctrl->obstaclesSeq;
+        }
+        body += "\n";
+        // Le client s'est déconnecté
+        if (mg_write(conn, body.data(), body.size()) <= 0) break;
+    }
+    return 200;
 }
 
-// Gestion de la page HTML
-int DisparityController::rootHandler(struct mg_connection *conn, void *param) {
-    FILE *file = fopen("resources/disparity.html", "r");
-    if (!file) {
+// Comparaison StereoBM / census sur la même paire rectifiée : /disparityBenchmark?iterations=20
+int DisparityController::benchmarkHandler(struct mg_connection *conn, void *param) {
+    DisparityController *ctrl = (DisparityController *)(param);
+    const struct mg_request_info *info = mg_get_request_info(conn);
+    char value[16] = "";
+    int iterations = 20;
+
+    if (info->query_string != nullptr &&
+        mg_get_var(info->query_string, strlen(info->query_string), "iterations", value, sizeof(value)) > 0) {
+        iterations = std::max(1, std::min(atoi(value), 1000));
+    }
+
+    // Paire rectifiée à partir des images courantes
+    cv::Mat frame1, frame2, gray1, gray2, rectified1, rectified2;
+    std::shared_ptr<const RectificationContext> ctx = ctrl->getRectification();
+    if (!ctx || !ctrl->captureManager->copyFrameById(ctrl->pair.left, frame1) ||
+        !ctrl->captureManager->copyFrameById(ctrl->pair.right, frame2)) {
         mg_printf(conn,
-                  "HTTP/1.1 404 Not Found\r\n"
+                  "HTTP/1.1 503 Service Unavailable\r\n"
                   "Content-Type: text/plain\r\n\r\n"
-                  "File not found!");
-        return 404;
+                  "No rectified pair available!");
+        return 503;
     }
+    cv::cvtColor(frame1, gray1, cv::COLOR_BGR2GRAY);
+    cv::cvtColor(frame2, gray2, cv::COLOR_BGR2GRAY);
+    cv::remap(gray1, rectified1, ctx->map1xy, ctx->map1frac, cv::INTER_LINEAR);
+    cv::remap(gray2, rectified2, ctx->map2xy, ctx->map2frac, cv::INTER_LINEAR);
 
-    // Lire le contenu du fichier
-    fseek(file, 0, SEEK_END);
-    size_t fileSize = ftell(file);
-    rewind(file);
-    std::vector<char> fileContent(fileSize);
-    fread(fileContent.data(), 1, fileSize, file);
-    fclose(file);
+    cv::Ptr<cv::StereoBM> stereo = cv::StereoBM::create(16, 15);
+    CensusMatcher census(16, 9);
+    cv::Mat result;
+
+    // Un premier passage pour les allocations, puis les mesures
+    stereo->compute(rectified1, rectified2, result);
+    cv::TickMeter bmTimer;
+    for (int i = 0 ; i < iterations ; i++) {
+        bmTimer.start();
+        stereo->compute(rectified1, rectified2, result);
+        bmTimer.stop();
+    }
+
+    census.compute(rectified1, rectified2, result);
+    cv::TickMeter censusTimer;
+    for (int i = 0 ; i < iterations ; i++) {
+        censusTimer.start();
+        census.compute(rectified1, rectified2, result);
+        censusTimer.stop();
+    }
+
+    std::string json = "{\"iterations\":" + std::to_string(iterations) +
+                       ",\"width\":" + std::to_string(rectified1.cols) +
+                       ",\"height\":" + std::to_string(rectified1.rows) +
+                       ",\"stereoBM_ms\":" + std::to_string(bmTimer.getTimeMilli() / iterations) +
+                       ",\"census_ms\":" + std::to_string(censusTimer.getTimeMilli() / iterations) + "}";
 
-    // Envoyer la réponse
     mg_printf(conn,
               "HTTP/1.1 200 OK\r\n"
-              "Content-Type: text/html\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
               "Content-Length: %zu\r\n\r\n",
-              fileSize);
-    mg_write(conn, fileContent.data(), fileSize);
+              json.size());
+    mg_write(conn, json.data(), json.size());
     return 200;
 }
+
+// Gestion de la page HTML
+int DisparityController::rootHandler(struct mg_connection *conn, void *param) {
+    return StaticResources::serve(conn, "disparity.html");
+}
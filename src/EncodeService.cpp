@@ -0,0 +1,221 @@
+#include "EncodeService.hpp"
+#include "JpegEncoder.hpp"
+#include "TaskScheduler.hpp"
+#include "FrameTracer.hpp"
+
+#include <chrono>
+#include <sstream>
+
+// Moyenne glissante sur une vingtaine d'images
+static void updateAverage(std::atomic<long>& average, long micros) {
+    long previous = average.load(std::memory_order_relaxed);
+    average.store(previous == 0 ? micros : previous + (micros - previous) / 16, std::memory_order_relaxed);
+}
+
+EncodeService& EncodeService::instance() {
+    static EncodeService service;
+    return service;
+}
+
+EncodeService::EncodeService() : nextStream(0), running(false) {}
+
+void EncodeService::start(int nbWorkers) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = true;
+    }
+    for (int i = 0 ; i < std::max(1, nbWorkers) ; i++) {
+        workers.push_back(TaskScheduler::instance().spawn("jpeg/" + std::to_string(i), STAGE_ENCODE,
+                                                          [this]() { worker(); }));
+    }
+}
+
+void EncodeService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    workCond.notify_all();
+    frameCond.notify_all();
+    for (std::thread& thread : workers) thread.join();
+    workers.clear();
+}
+
+int EncodeService::addStream(const std::string& name, const CopyFunction& copy, int quality) {
+    std::shared_ptr<Stream> stream(new Stream());
+    stream->name = name;
+    stream->copy = copy;
+    stream->quality = quality;
+    stream->trace = FrameTracer::intern("encode/" + name);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    streams[nextStream] = stream;
+    return nextStream++;
+}
+
+void EncodeService::removeStream(int id) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = streams.find(id);
+    if (it == streams.end()) return;
+    std::shared_ptr<Stream> stream = it->second;
+    streams.erase(it);
+    frameCond.notify_all();
+
+    // Un encodage en cours utilise encore la fonction de copie du flux
+    frameCond.wait(lock, [&]() { return !stream->busy; });
+}
+
+void EncodeService::notify(int id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = streams.find(id);
+        if (it == streams.end() || it->second->clients == 0) return;
+        it->second->dirty = true;
+    }
+    workCond.notify_one();
+}
+
+void EncodeService::subscribe(int id, int delta) {
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = streams.find(id);
+        if (it == streams.end()) return;
+        Stream& stream = *it->second;
+
+        // Sans client, l'image encodée vieillit : le prochain client attend une image fraîche,
+        // encodée tout de suite à partir de la dernière image du producteur
+        stream.clients += delta;
+        first = delta > 0 && stream.clients == delta;
+        if (stream.clients == 0) {
+            stream.latest.reset();
+            stream.encodedSeq = 0;
+            stream.generation++;
+        }
+        if (first) stream.dirty = true;
+    }
+    if (first) workCond.notify_one();
+}
+
+std::shared_ptr<const EncodedFrame> EncodeService::waitForFrame(int id, uint64_t afterSeq, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::shared_ptr<const EncodedFrame> frame;
+    frameCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+        auto it = streams.find(id);
+        if (!running || it == streams.end()) return true;
+        frame = it->second->latest;
+        return frame && frame->seq != afterSeq;
+    });
+    if (frame && frame->seq == afterSeq) frame.reset();
+    return frame;
+}
+
+// Sortie qu'aucun client n'envoie plus (seul le flux la référence), ou une nouvelle
+std::shared_ptr<EncodedFrame> EncodeService::acquireBuffer(Stream& stream) {
+    for (std::shared_ptr<EncodedFrame>& buffer : stream.buffers) {
+        if (buffer.use_count() == 1) return buffer;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    stream.buffers.push_back(std::make_shared<EncodedFrame>());
+    return stream.buffers.back();
+}
+
+void EncodeService::worker() {
+    // Encodeur et copies des images propres au thread, réutilisés
+    JpegEncoder encoder;
+    std::map<int, cv::Mat> frames;
+    int lastId = -1;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        // Tour de rôle : premier flux à encoder après le dernier traité par ce thread.
+        // Un flux pris par un thread est occupé : les autres passent aux suivants
+        std::shared_ptr<Stream> stream;
+        int id = -1;
+        for (auto& entry : streams) {
+            const Stream& candidate = *entry.second;
+            if (!candidate.dirty || candidate.busy || candidate.clients == 0) continue;
+            if (!stream || (id <= lastId && entry.first > lastId)) {
+                stream = entry.second;
+                id = entry.first;
+            }
+        }
+        if (!stream) {
+            workCond.wait(lock);
+            continue;
+        }
+        lastId = id;
+
+        stream->dirty = false;
+        stream->busy = true;
+        lock.unlock();
+        encode(*stream, id, frames, encoder);
+        lock.lock();
+
+        stream->busy = false;
+        frameCond.notify_all();
+        // Une image arrivée pendant l'encodage peut être prise par un autre thread
+        if (stream->dirty) workCond.notify_one();
+    }
+}
+
+// Encode la dernière image du flux, appelé sans le verrou du service
+void EncodeService::encode(Stream& stream, int id, std::map<int, cv::Mat>& frames, JpegEncoder& encoder) {
+    int generation;
+    uint64_t encodedSeq;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation = stream.generation;
+        encodedSeq = stream.latest ? stream.encodedSeq : 0;
+    }
+
+    FrameInfo info;
+    cv::Mat& frame = frames[id];
+    if (!stream.copy(frame, info) || (encodedSeq != 0 && info.seq == encodedSeq)) return;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::shared_ptr<EncodedFrame> buffer = acquireBuffer(stream);
+    bool encoded;
+    {
+        FrameTracer::Span span(stream.trace, info.seq);
+        encoded = encoder.encode(frame, stream.quality, buffer->data);
+    }
+    buffer->seq = info.seq;
+    buffer->timestamp = info.timestamp;
+    if (!encoded) return;
+
+    long micros = (long)std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start).count();
+    stream.frames++;
+    stream.lastMicros = micros;
+    updateAverage(stream.avgMicros, micros);
+    stream.bytes = (long)buffer->data.size();
+
+    // Le dernier client est parti pendant l'encodage : l'image n'est pas publiée
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stream.generation == generation && stream.clients > 0) {
+        stream.latest = buffer;
+        stream.encodedSeq = info.seq;
+    }
+}
+
+std::string EncodeService::statusJson() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream json;
+    json << "{\"workers\":" << workers.size() << ",\"streams\":[";
+    bool separator = false;
+    for (auto& entry : streams) {
+        const Stream& stream = *entry.second;
+        if (separator) json << ",";
+        separator = true;
+        json << "{\"name\":\"" << stream.name << "\""
+             << ",\"clients\":" << stream.clients
+             << ",\"frames\":" << stream.frames
+             << ",\"last_ms\":" << stream.lastMicros / 1000.0
+             << ",\"avg_ms\":" << stream.avgMicros / 1000.0
+             << ",\"bytes\":" << stream.bytes
+             << ",\"buffers\":" << stream.buffers.size() << "}";
+    }
+    json << "]}";
+    return json.str();
+}
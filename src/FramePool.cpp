@@ -0,0 +1,142 @@
+#include "FramePool.hpp"
+
+#include <iostream>
+#include <sstream>
+
+std::atomic<long> FramePool::allocations(0);
+std::atomic<long> FramePool::unattributed(0);
+thread_local FramePool::Counter FramePool::threadCounter(0);
+thread_local FramePool::Counter* FramePool::frameCounter = nullptr;
+
+namespace {
+
+// Allocateur standard d'OpenCV, avec comptage des nouveaux buffers.
+// Les buffers restent gérés par l'allocateur standard (libération comprise).
+class CountingAllocator : public cv::MatAllocator {
+
+    public:
+
+    CountingAllocator(cv::MatAllocator* standard) : standard(standard) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage) const override {
+        // Données fournies par l'appelant : rien n'est alloué
+        if (data == nullptr) FramePool::countAllocation();
+        return standard->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override {
+        return standard->allocate(data, flags, usage);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        standard->deallocate(data);
+    }
+
+    private:
+
+    cv::MatAllocator* standard;
+};
+
+}
+
+FramePool& FramePool::instance() {
+    static FramePool pool;
+    return pool;
+}
+
+// Jamais détruit : des buffers peuvent être libérés jusqu'à la fin du programme
+void FramePool::install() {
+    static CountingAllocator* allocator = new CountingAllocator(cv::Mat::getStdAllocator());
+    cv::Mat::setDefaultAllocator(allocator);
+}
+
+void FramePool::countAllocation() {
+    allocations++;
+    Counter* counter = frameCounter;
+    if (counter != nullptr) {
+        (*counter)++;
+    } else {
+        unattributed++;
+    }
+}
+
+void FramePool::ensure(cv::Mat& mat, const cv::Size& size, int type) {
+    mat.create(size, type);
+}
+
+FramePool::Counter* FramePool::currentCounter() {
+    return frameCounter;
+}
+
+FramePool::Scope::Scope(Counter* counter) : previous(frameCounter) {
+    frameCounter = counter;
+}
+
+FramePool::Scope::~Scope() {
+    frameCounter = previous;
+}
+
+void FramePool::beginFrame() {
+    threadCounter = 0;
+    frameCounter = &threadCounter;
+}
+
+// Retourne le nombre d'allocations faites pour l'image depuis beginFrame()
+long FramePool::endFrame(const std::string& stage, long warmupFrames) {
+    long frameAllocations = threadCounter;
+    frameCounter = nullptr;
+
+    FramePool& pool = instance();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    StageStats& stats = pool.stages[stage];
+    stats.frames++;
+    stats.allocations += frameAllocations;
+    stats.lastFrameAllocations = frameAllocations;
+
+    // Signalé une seule fois : le détail reste dans /pool
+    if (stats.frames > warmupFrames && frameAllocations > 0) {
+        if (stats.steadyAllocations == 0) {
+            std::cerr << "Attention : allocation(s) en régime établi dans l'étape " << stage << " (voir /pool)." << std::endl;
+        }
+        stats.steadyAllocations += frameAllocations;
+    }
+
+    return frameAllocations;
+}
+
+FramePool::Frame::Frame(const std::string& stage, long warmupFrames) : stage(stage), warmupFrames(warmupFrames) {
+    beginFrame();
+}
+
+FramePool::Frame::~Frame() {
+    endFrame(stage, warmupFrames);
+}
+
+long FramePool::unattributedAllocations() {
+    return unattributed;
+}
+
+std::string FramePool::statsJson() {
+    FramePool& pool = instance();
+    std::ostringstream json;
+    std::lock_guard<std::mutex> lock(pool.mutex);
+
+    json << "{\"allocations\":" << allocations.load()
+         << ",\"unattributed\":" << unattributed.load()
+         << ",\"stages\":[";
+
+    bool first = true;
+    for (const auto& entry : pool.stages) {
+        if (!first) json << ",";
+        first = false;
+        json << "{\"stage\":\"" << entry.first << "\""
+             << ",\"frames\":" << entry.second.frames
+             << ",\"allocations\":" << entry.second.allocations
+             << ",\"lastFrameAllocations\":" << entry.second.lastFrameAllocations
+             << ",\"steadyAllocations\":" << entry.second.steadyAllocations << "}";
+    }
+    json << "]}";
+
+    return json.str();
+}
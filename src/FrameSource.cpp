@@ -0,0 +1,160 @@
+#include "FrameSource.hpp"
+#include "StereoRecorder.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+// Périphérique vidéo (comportement historique)
+class DeviceSource : public FrameSource {
+
+    public:
+
+    DeviceSource(const CameraConfig& config) : cap(config.device) {
+        // Configurer la taille de l'image et la fréquence d'images
+        cap.set(cv::CAP_PROP_FRAME_WIDTH, config.width);
+        cap.set(cv::CAP_PROP_FRAME_HEIGHT, config.height);
+        cap.set(cv::CAP_PROP_FPS, config.fps);
+    }
+    ~DeviceSource() { cap.release(); }
+
+    bool isOpened() { return cap.isOpened(); }
+
+    bool read(cv::Mat& frame) override {
+        cap >> frame;
+        return !frame.empty();
+    }
+
+    private:
+
+    cv::VideoCapture cap;
+};
+
+// Mire texturée qui défile, décalée de BACKGROUND_DISPARITY pixels entre la
+// caméra gauche et la droite, avec un carré plus proche (OBJECT_DISPARITY) qui traverse l'image :
+// le calcul de disparité a donc un vrai travail à faire.
+class SyntheticSource : public FrameSource {
+
+    public:
+
+    SyntheticSource(const CameraConfig& config, CameraRole role)
+        : size(config.width, config.height), shift(role == CAMERA_RIGHT ? 1 : 0),
+          period(std::chrono::microseconds(1000000 / std::max(1, config.fps))),
+          next(Clock::now()), frameCount(0) {
+        texture = makeTexture(cv::Size(size.width + SCROLL + 2 * OBJECT_DISPARITY, size.height));
+    }
+
+    bool read(cv::Mat& frame) override {
+        std::this_thread::sleep_until(next);
+        next += period;
+        // Rattrapage sans rafale si le consommateur a pris du retard
+        if (next < Clock::now()) next = Clock::now() + period;
+
+        int scroll = (int)(frameCount * 2 % SCROLL);
+        cv::Mat gray = texture(cv::Rect(scroll + shift * BACKGROUND_DISPARITY, 0, size.width, size.height)).clone();
+
+        // Carré au premier plan, pris dans une autre zone de la texture
+        int side = size.height / 3;
+        int travel = std::max(1, size.width - side - OBJECT_DISPARITY);
+        int x = OBJECT_DISPARITY + (int)(frameCount * 3 % travel) - shift * OBJECT_DISPARITY;
+        cv::Rect square(x, size.height / 3, side, side);
+        texture(cv::Rect(texture.cols - side, 0, side, side)).copyTo(gray(square));
+
+        cv::cvtColor(gray, frame, cv::COLOR_GRAY2BGR);
+        frameCount++;
+        return true;
+    }
+
+    private:
+
+    static const int SCROLL = 256;
+    static const int BACKGROUND_DISPARITY = 8;
+    static const int OBJECT_DISPARITY = 24;
+
+    // Bruit lissé, identique pour toutes les caméras (graine fixe)
+    static cv::Mat makeTexture(cv::Size size) {
+        cv::Mat texture(size, CV_8UC1);
+        cv::RNG rng(0x5eed);
+        rng.fill(texture, cv::RNG::UNIFORM, 0, 256);
+        cv::GaussianBlur(texture, texture, cv::Size(5, 5), 1.5);
+        return texture;
+    }
+
+    cv::Size size;
+    int shift;  // 1 pour la caméra droite
+    Clock::duration period;
+    Clock::time_point next;
+    uint64_t frameCount;
+    cv::Mat texture;
+};
+
+// Relecture en boucle d'un flux d'enregistrement, au rythme des horodatages d'origine
+class ReplaySource : public FrameSource {
+
+    public:
+
+    ReplaySource(std::shared_ptr<const RecordingReader> reader, int stream)
+        : reader(reader), frames(reader->streamFrames(stream)), position(0) {}
+
+    bool isOpened() { return !frames.empty(); }
+
+    bool read(cv::Mat& frame) override {
+        if (frames.empty()) return false;
+        if (position == frames.size()) position = 0;
+
+        RecordedFrame recorded = reader->frame(frames[position]);
+        if (position == 0) {
+            start = Clock::now();
+            firstTimestamp = recorded.timestamp;
+        } else {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(recorded.timestamp - firstTimestamp));
+        }
+        position++;
+
+        // L'image projetée est en lecture seule : copie dans le buffer de capture,
+        // en couleur comme celles des caméras
+        if (recorded.image.channels() == 1) {
+            cv::cvtColor(recorded.image, frame, cv::COLOR_GRAY2BGR);
+        } else {
+            recorded.image.copyTo(frame);
+        }
+        return true;
+    }
+
+    private:
+
+    std::shared_ptr<const RecordingReader> reader;
+    const std::vector<size_t>& frames;
+    size_t position;
+    Clock::time_point start;
+    int64_t firstTimestamp = 0;
+};
+
+std::unique_ptr<FrameSource> FrameSource::create(const CameraConfig& config, CameraRole role) {
+    if (config.source == "synthetic") {
+        return std::unique_ptr<FrameSource>(new SyntheticSource(config, role));
+    }
+
+    if (config.source == "replay") {
+        // Seules les images des caméras (8 bits) peuvent remplacer une caméra, pas la disparité
+        if (config.stream != RECORD_LEFT && config.stream != RECORD_RIGHT) {
+            std::cerr << "Erreur : flux " << config.stream << " de " << config.file
+                      << " non relisible comme caméra (0 gauche, 1 droite)." << std::endl;
+            return nullptr;
+        }
+        std::shared_ptr<const RecordingReader> reader = RecordingReader::open(config.file);
+        if (!reader) {
+            std::cerr << "Erreur : enregistrement illisible : " << config.file << std::endl;
+            return nullptr;
+        }
+        std::unique_ptr<ReplaySource> source(new ReplaySource(reader, config.stream));
+        if (!source->isOpened()) return nullptr;
+        return std::move(source);
+    }
+
+    std::unique_ptr<DeviceSource> source(new DeviceSource(config));
+    if (!source->isOpened()) return nullptr;
+    return std::move(source);
+}
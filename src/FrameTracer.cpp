@@ -0,0 +1,103 @@
+#include "FrameTracer.hpp"
+#include "TaskScheduler.hpp"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int currentTid() {
+    static thread_local int tid = (int)syscall(SYS_gettid);
+    return tid;
+}
+
+FrameTracer& FrameTracer::instance() {
+    static FrameTracer tracer;
+    return tracer;
+}
+
+FrameTracer::FrameTracer() : events(new Event[CAPACITY]), next(0) {
+    for (size_t i = 0 ; i < CAPACITY ; i++) events[i].stamp = 0;
+}
+
+const char* FrameTracer::intern(const std::string& name) {
+    // Une deque ne déplace jamais ses éléments : les pointeurs restent valides
+    static std::mutex mutex;
+    static std::deque<std::string> names;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const std::string& existing : names) {
+        if (existing == name) return existing.c_str();
+    }
+    names.push_back(name);
+    return names.back().c_str();
+}
+
+int64_t FrameTracer::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameTracer::record(const char* name, uint64_t seq, int64_t start, int64_t end) {
+    uint64_t index = next.fetch_add(1, std::memory_order_relaxed);
+    Event& event = events[index & (CAPACITY - 1)];
+
+    event.stamp.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.seq.store(seq, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(end - start, std::memory_order_relaxed);
+    event.tid.store(currentTid(), std::memory_order_relaxed);
+    event.stamp.store(2 * index + 2, std::memory_order_release);
+}
+
+std::string FrameTracer::chromeTraceJson(double seconds) {
+    int64_t cutoff = now() - (int64_t)(seconds * 1e6);
+    uint64_t last = next.load(std::memory_order_acquire);
+    uint64_t first = last > CAPACITY ? last - CAPACITY : 0;
+
+    std::ostringstream json;
+    std::map<int, bool> tids;
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool separator = false;
+
+    for (uint64_t index = first ; index < last ; index++) {
+        const Event& event = events[index & (CAPACITY - 1)];
+
+        // Lecture cohérente seulement si l'intervalle n'a pas été réécrit entre-temps
+        uint64_t stamp = event.stamp.load(std::memory_order_acquire);
+        const char* name = event.name.load(std::memory_order_relaxed);
+        uint64_t seq = event.seq.load(std::memory_order_relaxed);
+        int64_t start = event.start.load(std::memory_order_relaxed);
+        int64_t duration = event.duration.load(std::memory_order_relaxed);
+        int tid = event.tid.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (stamp != 2 * index + 2 || event.stamp.load(std::memory_order_relaxed) != stamp) continue;
+        if (start + duration < cutoff) continue;
+
+        if (separator) json << ",";
+        separator = true;
+        json << "{\"name\":\"" << name << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1"
+             << ",\"tid\":" << tid << ",\"ts\":" << start << ",\"dur\":" << duration
+             << ",\"args\":{\"seq\":" << seq << "}}";
+        tids[tid] = true;
+    }
+
+    // Noms des threads connus de l'ordonnanceur
+    std::map<int, std::string> names = TaskScheduler::instance().threadNames();
+    for (auto& entry : tids) {
+        auto name = names.find(entry.first);
+        if (name == names.end()) continue;
+        if (separator) json << ",";
+        separator = true;
+        json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << entry.first
+             << ",\"args\":{\"name\":\"" << name->second << "\"}}";
+    }
+    json << "]}";
+
+    return json.str();
+}
@@ -1,73 +1,60 @@
 #include "IndexController.hpp"
 
-// Définition des variables statiques
-std::mutex IndexController::frameMutexes[NB_WEBCAMS];
-cv::Mat IndexController::frames[NB_WEBCAMS];
-int IndexController::cameraDevice[NB_WEBCAMS];
-bool IndexController::running;
-int IndexController::cameraID[NB_WEBCAMS];
-
 // Constructeur de la classe
-IndexController::IndexController(struct mg_context* ctx) {
-
-    // Initialise les identifiants des caméras
-    cameraID[0] = 0;
-    cameraID[1] = 1;
-    cameraDevice[0] = 0;
-    cameraDevice[1] = 2;
+IndexController::IndexController(struct mg_context* ctx, CaptureManager* captureManager) {
+    this->captureManager = captureManager;
+
+    // Un flux par caméra : /video1, /video2, ...
+    // Les paramètres sont créés avant l'enregistrement pour que leurs adresses restent stables
+    // Chaque nouvelle image est encodée une fois par le service d'encodage, quel que soit le nombre de clients
+    for (int i = 0 ; i < captureManager->getNbCameras() ; i++) {
+        int encodeID = EncodeService::instance().addStream(captureManager->getCamera(i).name,
+            [captureManager, i](cv::Mat& frame, FrameInfo& info) { return captureManager->copyFrameById(i, frame, &info); });
+        streamParams.push_back({this, i, encodeID});
+        streamRoutes.push_back("/video" + std::to_string(i + 1));
+    }
 
-    // Lance les threads de capture vidéo
-    capThread1 = std::thread(IndexController::captureThread, cameraID[0]);
-    capThread2 = std::thread(IndexController::captureThread, cameraID[1]);
+    // Les threads de capture signalent chaque nouvelle image au service d'encodage
+    std::vector<int> encodeIDs;
+    for (const StreamParam& stream : streamParams) encodeIDs.push_back(stream.encodeID);
+    encodeObserver = captureManager->addFrameObserver(
+        [encodeIDs](int camID, uint64_t, int64_t, const cv::Mat&) { EncodeService::instance().notify(encodeIDs[camID]); });
 
     // Configure les handlers
     if (ctx == nullptr) {
         std::cerr << "Erreur : impossible de démarrer le serveur HTTP." << std::endl;
         running = false;
     } else {
-        mg_set_request_handler(ctx, "/video1", streamHandler, &cameraID[0]);
-        mg_set_request_handler(ctx, "/video2", streamHandler, &cameraID[1]);
+        for (size_t i = 0 ; i < streamParams.size() ; i++) {
+            mg_set_request_handler(ctx, streamRoutes[i].c_str(), streamHandler, &streamParams[i]);
+        }
+        mg_set_request_handler(ctx, "/cameras", camerasHandler, this);
+        mg_set_request_handler(ctx, "/stages", stagesHandler, nullptr);
+        mg_set_request_handler(ctx, "/pool", poolHandler, nullptr);
+        mg_set_request_handler(ctx, "/threads", threadsHandler, nullptr);
+        mg_set_request_handler(ctx, "/trace", traceHandler, nullptr);
+        mg_set_request_handler(ctx, "/encoders", encodersHandler, nullptr);
         mg_set_request_handler(ctx, "/", rootHandler, nullptr);
         running = true;
     }
 }
 
-// Destructeur
-IndexController::~IndexController() {
+void IndexController::stop() {
     running = false;
-    capThread1.join();
-    capThread2.join();
 }
 
-// Thread séparé qui capture le flux des caméras
-void IndexController::captureThread(int camID) {
-    cv::VideoCapture cap(cameraDevice[camID]);
-    if (!cap.isOpened()) {
-        std::cerr << "Erreur : impossible d'ouvrir la caméra. ID = " << camID << std::endl;
-        return;
-    }
-
-    // Configurer la taille de l'image et la fréquence d'images (facultatif)
-    cap.set(cv::CAP_PROP_FRAME_WIDTH, 640);
-    cap.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
-    cap.set(cv::CAP_PROP_FPS, 30);
-
-    while (running) {
-        cv::Mat temp_frame;
-        cap >> temp_frame; // Capture une nouvelle image
-        if (temp_frame.empty()) continue;
-
-        {
-            std::lock_guard<std::mutex> lock(frameMutexes[camID]);
-            frames[camID] = temp_frame.clone();
-        }
-    }
-    cap.release();
+// Destructeur
+IndexController::~IndexController() {
+    stop();
+    captureManager->removeFrameObserver(encodeObserver);
+    for (const StreamParam& stream : streamParams) EncodeService::instance().removeStream(stream.encodeID);
 }
 
 // Gestionnaire de la requête, affiche le flux MJPEG
 int IndexController::streamHandler(struct mg_connection *conn, void *param) {
-    int *cameraID = (int *)(param);
+    StreamParam *stream = (StreamParam *)(param);
+    IndexController *ctrl = stream->ctrl;
+    TaskScheduler::Adoption adoption("http", STAGE_ENCODE);
 
     // En-têtes pour le flux MJPEG
     mg_printf(conn,
@@ -76,70 +63,129 @@ int IndexController::streamHandler(struct mg_connection *conn, void *param) {
               "Cache-Control: no-cache\r\n"
               "\r\n");
 
-    while (running) {
-        std::vector<uchar> buf;
-
-        {
-            std::lock_guard<std::mutex> lock(frameMutexes[*cameraID]);
-            if (!frames[*cameraID].empty()) {
-                cv::imencode(".jpg", frames[*cameraID], buf);
-            }
-        }
+    EncodeService::Subscription subscription(stream->encodeID);
+    std::string camera = ctrl->captureManager->getCamera(stream->camID).name;
+    const char* writeTrace = FrameTracer::intern("write/" + camera);
+    uint64_t lastSeq = 0;
 
-        if (!buf.empty()) {
-            mg_printf(conn,
-                      "--frame\r\n"
-                      "Content-Type: image/jpeg\r\n"
-                      "Content-Length: %lu\r\n\r\n",
-                      buf.size());
-            mg_write(conn, buf.data(), buf.size());
-            mg_printf(conn, "\r\n");
-        }
+    // Seules les nouvelles images sont envoyées, au rythme de la caméra
+    while (ctrl->running) {
+        std::shared_ptr<const EncodedFrame> frame = EncodeService::instance().waitForFrame(stream->encodeID, lastSeq, 500);
+        if (!frame) continue;
+        lastSeq = frame->seq;
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(33)); // ~30 FPS
+        // Numéro et heure de capture : le client calcule la latence de bout en bout
+        FrameTracer::Span span(writeTrace, frame->seq);
+        mg_printf(conn,
+                  "--frame\r\n"
+                  "Content-Type: image/jpeg\r\n"
+                  "X-Frame-Seq: %llu\r\n"
+                  "X-Capture-Timestamp: %lld\r\n"
+                  "Content-Length: %lu\r\n\r\n",
+                  (unsigned long long)frame->seq, (long long)frame->timestamp, frame->data.size());
+        // Le client s'est déconnecté
+        if (mg_write(conn, frame->data.data(), frame->data.size()) <= 0) break;
+        mg_printf(conn, "\r\n");
     }
 
     return 200; // Réponse HTTP réussie
 }
 
-// Gestion de la page HTML
-int IndexController::rootHandler(struct mg_connection *conn, void *param) {
-    FILE *file = fopen("resources/index.html", "r");
-    if (!file) {
-        mg_printf(conn,
-                  "HTTP/1.1 404 Not Found\r\n"
-                  "Content-Type: text/plain\r\n\r\n"
-                  "File not found!");
-        return 404;
-    }
+// Liste des caméras et des paires stéréo
+int IndexController::camerasHandler(struct mg_connection *conn, void *param) {
+    IndexController *ctrl = (IndexController *)(param);
+    std::string json = ctrl->captureManager->toJson();
+
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
+    return 200;
+}
 
-    // Lire le contenu du fichier
-    fseek(file, 0, SEEK_END);
-    size_t fileSize = ftell(file);
-    rewind(file);
-    std::vector<char> fileContent(fileSize);
-    fread(fileContent.data(), 1, fileSize, file);
-    fclose(file);
+// Etat actif / en veille des étapes de traitement
+int IndexController::stagesHandler(struct mg_connection *conn, void *param) {
+    std::string json = StreamDemand::statusJson();
 
-    // Envoyer la réponse
     mg_printf(conn,
               "HTTP/1.1 200 OK\r\n"
-              "Content-Type: text/html\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
               "Content-Length: %zu\r\n\r\n",
-              fileSize);
-    mg_write(conn, fileContent.data(), fileSize);
+              json.size());
+    mg_write(conn, json.data(), json.size());
     return 200;
 }
 
-cv::Mat IndexController::getFrameById(int id) {
-    cv::Mat frame;
+// Statistiques d'allocation des buffers d'image
+int IndexController::poolHandler(struct mg_connection *conn, void *param) {
+    std::string json = FramePool::statsJson();
 
-    {
-        std::lock_guard<std::mutex> lock(frameMutexes[id]);
-        if (!frames[id].empty()) {
-            frame = frames[id].clone();
-        }
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
+    return 200;
+}
+
+// Utilisation CPU par thread
+int IndexController::threadsHandler(struct mg_connection *conn, void *param) {
+    std::string json = TaskScheduler::instance().threadsJson();
+
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
+    return 200;
+}
+
+// Temps d'encodage et clients de chaque flux MJPEG
+int IndexController::encodersHandler(struct mg_connection *conn, void *param) {
+    std::string json = EncodeService::instance().statusJson();
+
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
+    return 200;
+}
+
+// Traces des dernières secondes au format Chrome : /trace?seconds=5
+int IndexController::traceHandler(struct mg_connection *conn, void *param) {
+    const struct mg_request_info *info = mg_get_request_info(conn);
+    char value[16] = "";
+    double seconds = 5;
+
+    if (info->query_string != nullptr &&
+        mg_get_var(info->query_string, strlen(info->query_string), "seconds", value, sizeof(value)) > 0) {
+        seconds = std::max(0.1, std::min(atof(value), 60.0));
     }
 
-    return frame;
-}
\ No newline at end of file
+    std::string json = FrameTracer::instance().chromeTraceJson(seconds);
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Content-Disposition: attachment; filename=\"trace.json\"\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              json.size());
+    mg_write(conn, json.data(), json.size());
+    return 200;
+}
+
+// Gestion de la page HTML
+int IndexController::rootHandler(struct mg_connection *conn, void *param) {
+    return StaticResources::serve(conn, "index.html");
+}
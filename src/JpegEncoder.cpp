@@ -0,0 +1,117 @@
+#include "JpegEncoder.hpp"
+
+// Taille initiale de la sortie, agrandie au besoin puis conservée
+static const size_t INITIAL_OUTPUT_SIZE = 64 * 1024;
+
+#include <cstring>
+
+JpegEncoder::JpegEncoder() : output(nullptr), lastComponents(0), lastQuality(-1) {
+    cinfo.err = jpeg_std_error(&error.pub);
+    error.pub.error_exit = errorExit;
+    jpeg_create_compress(&cinfo);
+    cinfo.client_data = this;
+
+    destination.init_destination = initDestination;
+    destination.empty_output_buffer = emptyOutputBuffer;
+    destination.term_destination = termDestination;
+    cinfo.dest = &destination;
+}
+
+JpegEncoder::~JpegEncoder() {
+    jpeg_destroy_compress(&cinfo);
+}
+
+void JpegEncoder::errorExit(j_common_ptr cinfo) {
+    ErrorManager* error = (ErrorManager*)cinfo->err;
+    longjmp(error->jump, 1);
+}
+
+// Agrandit le buffer en gardant ses keep premiers octets ; rien n'est initialisé
+void JpegEncoder::reserve(JpegBuffer& out, size_t capacity, size_t keep) {
+    if (capacity <= out.capacity) return;
+    std::unique_ptr<uchar[]> bytes(new uchar[capacity]);
+    if (keep > 0) std::memcpy(bytes.get(), out.bytes.get(), keep);
+    out.bytes = std::move(bytes);
+    out.capacity = capacity;
+}
+
+// Écriture directe dans toute la capacité du buffer
+void JpegEncoder::initDestination(j_compress_ptr cinfo) {
+    JpegBuffer& out = *((JpegEncoder*)cinfo->client_data)->output;
+    reserve(out, INITIAL_OUTPUT_SIZE, 0);
+    out.used = 0;
+    cinfo->dest->next_output_byte = out.bytes.get();
+    cinfo->dest->free_in_buffer = out.capacity;
+}
+
+// Sortie pleine : libjpeg demande toujours le buffer entier
+boolean JpegEncoder::emptyOutputBuffer(j_compress_ptr cinfo) {
+    JpegBuffer& out = *((JpegEncoder*)cinfo->client_data)->output;
+    size_t used = out.capacity;
+    reserve(out, used * 2, used);
+    cinfo->dest->next_output_byte = out.bytes.get() + used;
+    cinfo->dest->free_in_buffer = out.capacity - used;
+    return TRUE;
+}
+
+void JpegEncoder::termDestination(j_compress_ptr cinfo) {
+    JpegBuffer& out = *((JpegEncoder*)cinfo->client_data)->output;
+    out.used = out.capacity - cinfo->dest->free_in_buffer;
+}
+
+bool JpegEncoder::encode(const cv::Mat& image, int quality, JpegBuffer& out) {
+    if (image.empty()) return false;
+    if (image.type() != CV_8UC1 && image.type() != CV_8UC3) {
+        if (!cv::imencode(".jpg", image, fallback, {cv::IMWRITE_JPEG_QUALITY, quality})) return false;
+        reserve(out, fallback.size(), 0);
+        std::memcpy(out.bytes.get(), fallback.data(), fallback.size());
+        out.used = fallback.size();
+        return true;
+    }
+
+    output = &out;
+    if (setjmp(error.jump)) {
+        jpeg_abort_compress(&cinfo);
+        out.used = 0;
+        lastQuality = -1;
+        return false;
+    }
+
+    // Les paramètres restent dans le contexte d'une compression à l'autre : les
+    // valeurs par défaut et les tables de quantification ne sont refaites qu'au changement
+    bool gray = image.channels() == 1;
+    cinfo.image_width = image.cols;
+    cinfo.image_height = image.rows;
+    if (image.channels() != lastComponents || quality != lastQuality) {
+        cinfo.input_components = image.channels();
+#ifdef JCS_EXTENSIONS
+        cinfo.in_color_space = gray ? JCS_GRAYSCALE : JCS_EXT_BGR;
+#else
+        cinfo.in_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+#endif
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        lastComponents = image.channels();
+        lastQuality = quality;
+    }
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = (JSAMPROW)image.ptr(cinfo.next_scanline);
+#ifndef JCS_EXTENSIONS
+        if (!gray) {
+            rowBuffer.resize(image.cols * 3);
+            for (int x = 0 ; x < image.cols * 3 ; x += 3) {
+                rowBuffer[x] = row[x + 2];
+                rowBuffer[x + 1] = row[x + 1];
+                rowBuffer[x + 2] = row[x];
+            }
+            row = rowBuffer.data();
+        }
+#endif
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    return true;
+}
@@ -0,0 +1,92 @@
+#include "ObstacleMap.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+ObstacleMap::ObstacleMap(double maxDistance, double minHeight, double maxHeight)
+    : maxDistance(maxDistance), minHeight(minHeight), maxHeight(maxHeight),
+      columnDepths(COLUMNS), cellCounts(GRID_SIZE * GRID_SIZE) {}
+
+void ObstacleMap::compute(const cv::Mat& disparity16, const cv::Mat& Q, ObstacleSummary& summary) {
+    // [X Y Z W] = Q [x y d 1] : seules ces composantes de Q sont non nulles
+    double q00 = Q.at<double>(0, 0), q03 = Q.at<double>(0, 3);
+    double q11 = Q.at<double>(1, 1), q13 = Q.at<double>(1, 3);
+    double q23 = Q.at<double>(2, 3), q32 = Q.at<double>(3, 2), q33 = Q.at<double>(3, 3);
+    double cellSize = maxDistance / GRID_SIZE;
+
+    for (std::vector<float>& depths : columnDepths) depths.clear();
+    std::fill(cellCounts.begin(), cellCounts.end(), 0);
+    xNumerators.resize(disparity16.cols);
+    for (int x = 0 ; x < disparity16.cols ; x++) xNumerators[x] = x * q00 + q03;
+
+    for (int y = 0 ; y < disparity16.rows ; y += STEP) {
+        const short* row = disparity16.ptr<short>(y);
+        double yNumerator = y * q11 + q13;
+
+        for (int x = 0 ; x < disparity16.cols ; x += STEP) {
+            if (row[x] <= 0) continue;  // -16 : pixel invalide
+            double w = row[x] / 16.0 * q32 + q33;
+            if (w == 0) continue;
+
+            // Le signe de W dépend du sens de la base : le point est remis devant la caméra
+            double Z = q23 / w, X = xNumerators[x] / w, Y = yNumerator / w;
+            if (Z < 0) {
+                Z = -Z;
+                X = -X;
+                Y = -Y;
+            }
+            if (Z > maxDistance || Y < minHeight || Y > maxHeight) continue;
+
+            columnDepths[x * COLUMNS / disparity16.cols].push_back((float)Z);
+
+            int cellX = (int)((X + maxDistance / 2) / cellSize);
+            int cellZ = (int)(Z / cellSize);
+            if (cellX < 0 || cellX >= GRID_SIZE || cellZ >= GRID_SIZE) continue;
+            uint16_t& count = cellCounts[cellZ * GRID_SIZE + cellX];
+            if (count < UINT16_MAX) count++;
+        }
+    }
+
+    // Distance de la bande : MIN_POINTS-ième point le plus proche
+    summary.columns.assign(COLUMNS, 0);
+    summary.nearest = 0;
+    summary.nearestColumn = -1;
+    for (int i = 0 ; i < COLUMNS ; i++) {
+        std::vector<float>& depths = columnDepths[i];
+        if ((int)depths.size() < MIN_POINTS) continue;
+        std::nth_element(depths.begin(), depths.begin() + (MIN_POINTS - 1), depths.end());
+        uint16_t millimeters = (uint16_t)std::min(65535.0f, depths[MIN_POINTS - 1] * 1000);
+        summary.columns[i] = std::max<uint16_t>(1, millimeters);
+        if (summary.nearestColumn < 0 || summary.columns[i] < summary.nearest) {
+            summary.nearest = summary.columns[i];
+            summary.nearestColumn = i;
+        }
+    }
+
+    summary.grid.assign(GRID_SIZE * GRID_SIZE / 8, 0);
+    for (int i = 0 ; i < GRID_SIZE * GRID_SIZE ; i++) {
+        if (cellCounts[i] >= MIN_POINTS) summary.grid[i / 8] |= (uint8_t)(1 << (i % 8));
+    }
+}
+
+// Grille en hexadécimal : octet i = cellules 8i à 8i+7, bit de poids faible en premier
+std::string ObstacleMap::toJson(const ObstacleSummary& summary) const {
+    static const char HEX[] = "0123456789abcdef";
+
+    std::ostringstream json;
+    json << "{\"seq\":" << summary.seq
+         << ",\"timestamp\":" << summary.timestamp
+         << ",\"nearest_mm\":" << summary.nearest
+         << ",\"nearest_column\":" << summary.nearestColumn
+         << ",\"columns\":[";
+    for (size_t i = 0 ; i < summary.columns.size() ; i++) {
+        if (i > 0) json << ",";
+        json << summary.columns[i];
+    }
+    json << "],\"grid\":{\"size\":" << GRID_SIZE
+         << ",\"cell_m\":" << maxDistance / GRID_SIZE
+         << ",\"bits\":\"";
+    for (uint8_t byte : summary.grid) json << HEX[byte >> 4] << HEX[byte & 15];
+    json << "\"}}";
+    return json.str();
+}
@@ -0,0 +1,118 @@
+#include "PoseCoverage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+// Seuils des cases : tailles (racine de la fraction de surface) et inclinaison minimale
+static const float SCALE_LIMITS[PoseCoverage::SCALE_BINS - 1] = {0.3f, 0.5f};
+static const float TILT_THRESHOLD = 0.05f;
+
+static float length(const cv::Point2f& a, const cv::Point2f& b) {
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+}
+
+static int count(const bool* bins, int nbBins) {
+    return (int)std::count(bins, bins + nbBins, true);
+}
+
+float BoardPose::distance(const BoardPose& other) const {
+    return std::max({std::fabs(x - other.x), std::fabs(y - other.y), std::fabs(scale - other.scale),
+                     std::fabs(tiltX - other.tiltX), std::fabs(tiltY - other.tiltY)});
+}
+
+PoseCoverage::PoseCoverage() {
+    clear();
+}
+
+BoardPose PoseCoverage::measure(const std::vector<cv::Point2f>& corners, const cv::Size& boardSize,
+                                const cv::Size& imageSize) {
+    // Coins extérieurs (les coins sont rangés ligne par ligne). findChessboardCorners peut
+    // rendre l'échiquier retourné de 180° (ou de 90° s'il est carré) : les coins sont
+    // remis dans l'ordre de l'image, sinon les inclinaisons s'inverseraient d'une image à l'autre
+    std::vector<cv::Point2f> outer = {corners[0], corners[boardSize.width - 1],
+                                      corners[boardSize.height * boardSize.width - 1],
+                                      corners[(boardSize.height - 1) * boardSize.width]};
+    cv::Point2f center = (outer[0] + outer[1] + outer[2] + outer[3]) * 0.25f;
+
+    // Sens horaire à l'écran (y vers le bas), en partant du coin le plus en haut à gauche
+    std::sort(outer.begin(), outer.end(), [&center](const cv::Point2f& a, const cv::Point2f& b) {
+        return std::atan2(a.y - center.y, a.x - center.x) < std::atan2(b.y - center.y, b.x - center.x);
+    });
+    std::rotate(outer.begin(), std::min_element(outer.begin(), outer.end(),
+                [](const cv::Point2f& a, const cv::Point2f& b) { return a.x + a.y < b.x + b.y; }), outer.end());
+
+    const cv::Point2f& topLeft = outer[0];
+    const cv::Point2f& topRight = outer[1];
+    const cv::Point2f& bottomRight = outer[2];
+    const cv::Point2f& bottomLeft = outer[3];
+
+    BoardPose pose;
+    pose.x = (topLeft.x + topRight.x + bottomLeft.x + bottomRight.x) / (4.0f * imageSize.width);
+    pose.y = (topLeft.y + topRight.y + bottomLeft.y + bottomRight.y) / (4.0f * imageSize.height);
+
+    // Surface du quadrilatère (formule du lacet)
+    float area = 0.5f * std::fabs((topLeft.x * topRight.y - topRight.x * topLeft.y) +
+                                  (topRight.x * bottomRight.y - bottomRight.x * topRight.y) +
+                                  (bottomRight.x * bottomLeft.y - bottomLeft.x * bottomRight.y) +
+                                  (bottomLeft.x * topLeft.y - topLeft.x * bottomLeft.y));
+    pose.scale = std::sqrt(area / ((float)imageSize.width * imageSize.height));
+
+    // La perspective raccourcit le bord le plus éloigné
+    float left = length(topLeft, bottomLeft), right = length(topRight, bottomRight);
+    float top = length(topLeft, topRight), bottom = length(bottomLeft, bottomRight);
+    pose.tiltX = (left - right) / std::max(left + right, 1.0f);
+    pose.tiltY = (top - bottom) / std::max(top + bottom, 1.0f);
+    return pose;
+}
+
+int PoseCoverage::positionBin(const BoardPose& pose) {
+    int column = std::min(std::max((int)(pose.x * POSITION_BINS), 0), POSITION_BINS - 1);
+    int row = std::min(std::max((int)(pose.y * POSITION_BINS), 0), POSITION_BINS - 1);
+    return row * POSITION_BINS + column;
+}
+
+int PoseCoverage::scaleBin(const BoardPose& pose) {
+    int bin = 0;
+    while (bin < SCALE_BINS - 1 && pose.scale >= SCALE_LIMITS[bin]) bin++;
+    return bin;
+}
+
+int PoseCoverage::tiltBin(const BoardPose& pose) {
+    if (std::max(std::fabs(pose.tiltX), std::fabs(pose.tiltY)) < TILT_THRESHOLD) return 0;
+    if (std::fabs(pose.tiltX) >= std::fabs(pose.tiltY)) return pose.tiltX > 0 ? 1 : 2;
+    return pose.tiltY > 0 ? 3 : 4;
+}
+
+bool PoseCoverage::adds(const BoardPose& pose) const {
+    return !positions[positionBin(pose)] || !scales[scaleBin(pose)] || !tilts[tiltBin(pose)];
+}
+
+void PoseCoverage::add(const BoardPose& pose) {
+    positions[positionBin(pose)] = true;
+    scales[scaleBin(pose)] = true;
+    tilts[tiltBin(pose)] = true;
+}
+
+bool PoseCoverage::complete() const {
+    return count(positions, POSITION_BINS * POSITION_BINS) == POSITION_BINS * POSITION_BINS &&
+           count(scales, SCALE_BINS) == SCALE_BINS && count(tilts, TILT_BINS) == TILT_BINS;
+}
+
+void PoseCoverage::clear() {
+    std::fill(positions, positions + POSITION_BINS * POSITION_BINS, false);
+    std::fill(scales, scales + SCALE_BINS, false);
+    std::fill(tilts, tilts + TILT_BINS, false);
+}
+
+std::string PoseCoverage::toJson() const {
+    std::ostringstream json;
+    json << "{\"positions\":" << count(positions, POSITION_BINS * POSITION_BINS)
+         << ",\"positionsTarget\":" << POSITION_BINS * POSITION_BINS
+         << ",\"scales\":" << count(scales, SCALE_BINS)
+         << ",\"scalesTarget\":" << SCALE_BINS
+         << ",\"tilts\":" << count(tilts, TILT_BINS)
+         << ",\"tiltsTarget\":" << TILT_BINS
+         << ",\"complete\":" << (complete() ? "true" : "false") << "}";
+    return json.str();
+}
@@ -0,0 +1,289 @@
+#include "RectificationContext.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Format du bundle (ordre des octets natif, données alignées sur 64 octets) :
+// en-tête, table des matrices, puis données brutes des matrices
+const char BUNDLE_MAGIC[8] = {'P', 'V', 'C', 'A', 'L', 'I', 'B', '\0'};
+const size_t BUNDLE_ALIGN = 64;
+
+struct BundleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nbEntries;
+    int32_t width;
+    int32_t height;
+};
+
+struct BundleEntry {
+    char name[24];
+    int32_t type;
+    int32_t rows;
+    int32_t cols;
+    int32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Matrices enregistrées dans le bundle, avec le seul type accepté à la lecture
+const struct {
+    const char* name;
+    cv::Mat RectificationContext::*mat;
+    int type;
+} BUNDLE_MATS[] = {
+    {"cameraMatrix1", &RectificationContext::cameraMatrix1, CV_64F},
+    {"distCoeffs1", &RectificationContext::distCoeffs1, CV_64F},
+    {"cameraMatrix2", &RectificationContext::cameraMatrix2, CV_64F},
+    {"distCoeffs2", &RectificationContext::distCoeffs2, CV_64F},
+    {"R", &RectificationContext::R, CV_64F},
+    {"T", &RectificationContext::T, CV_64F},
+    {"R1", &RectificationContext::R1, CV_64F},
+    {"R2", &RectificationContext::R2, CV_64F},
+    {"P1", &RectificationContext::P1, CV_64F},
+    {"P2", &RectificationContext::P2, CV_64F},
+    {"Q", &RectificationContext::Q, CV_64F},
+    {"map1xy", &RectificationContext::map1xy, CV_16SC2},
+    {"map1frac", &RectificationContext::map1frac, CV_16UC1},
+    {"map2xy", &RectificationContext::map2xy, CV_16SC2},
+    {"map2frac", &RectificationContext::map2frac, CV_16UC1},
+};
+const size_t NB_BUNDLE_MATS = sizeof(BUNDLE_MATS) / sizeof(BUNDLE_MATS[0]);
+
+size_t align(size_t offset) {
+    return (offset + BUNDLE_ALIGN - 1) / BUNDLE_ALIGN * BUNDLE_ALIGN;
+}
+
+cv::Mat rectToMat(const cv::Rect& rect) {
+    return (cv::Mat_<int>(1, 4) << rect.x, rect.y, rect.width, rect.height);
+}
+
+// Type attendu d'une entrée du bundle, -1 si le nom est inconnu
+int bundleType(const std::string& name) {
+    if (name == "roi1" || name == "roi2") return CV_32S;
+    for (size_t i = 0 ; i < NB_BUNDLE_MATS ; i++) {
+        if (name == BUNDLE_MATS[i].name) return BUNDLE_MATS[i].type;
+    }
+    return -1;
+}
+
+cv::Rect matToRect(const cv::Mat& mat) {
+    if (mat.type() != CV_32S || mat.total() != 4) return cv::Rect();
+    const int* v = mat.ptr<int>();
+    return cv::Rect(v[0], v[1], v[2], v[3]);
+}
+
+}
+
+// Chargement des paramétres de calibration
+bool RectificationContext::loadCalibration(const std::string& filename,
+                     cv::Mat& cameraMatrix1, cv::Mat& distCoeffs1,
+                     cv::Mat& cameraMatrix2, cv::Mat& distCoeffs2,
+                     cv::Mat& R, cv::Mat& T) {
+    try {
+        cv::FileStorage fs(filename, cv::FileStorage::READ);
+        if (!fs.isOpened()) return false;
+        fs["cameraMatrix1"] >> cameraMatrix1;
+        fs["distCoeffs1"] >> distCoeffs1;
+        fs["cameraMatrix2"] >> cameraMatrix2;
+        fs["distCoeffs2"] >> distCoeffs2;
+        fs["R"] >> R;
+        fs["T"] >> T;
+        fs.release();
+    } catch (const cv::Exception& e) {
+        // Fichier en cours d'écriture ou corrompu
+        std::cerr << "Erreur : lecture de la calibration impossible : " << e.what() << std::endl;
+        return false;
+    }
+
+    return !cameraMatrix1.empty() && !distCoeffs1.empty() &&
+           !cameraMatrix2.empty() && !distCoeffs2.empty() &&
+           !R.empty() && !T.empty();
+}
+
+// Construction complète du contexte (calcul des maps inclus)
+std::shared_ptr<const RectificationContext> RectificationContext::fromCalibration(
+                     const cv::Mat& cameraMatrix1, const cv::Mat& distCoeffs1,
+                     const cv::Mat& cameraMatrix2, const cv::Mat& distCoeffs2,
+                     const cv::Mat& R, const cv::Mat& T, const cv::Size& imageSize) {
+    std::shared_ptr<RectificationContext> ctx(new RectificationContext());
+    ctx->imageSize = imageSize;
+    ctx->cameraMatrix1 = cameraMatrix1;
+    ctx->distCoeffs1 = distCoeffs1;
+    ctx->cameraMatrix2 = cameraMatrix2;
+    ctx->distCoeffs2 = distCoeffs2;
+    ctx->R = R;
+    ctx->T = T;
+
+    cv::stereoRectify(ctx->cameraMatrix1, ctx->distCoeffs1, ctx->cameraMatrix2, ctx->distCoeffs2,
+                      imageSize, ctx->R, ctx->T, ctx->R1, ctx->R2, ctx->P1, ctx->P2, ctx->Q,
+                      cv::CALIB_ZERO_DISPARITY, -1, imageSize, &ctx->roi1, &ctx->roi2);
+
+    cv::initUndistortRectifyMap(ctx->cameraMatrix1, ctx->distCoeffs1, ctx->R1, ctx->P1, imageSize, CV_16SC2, ctx->map1xy, ctx->map1frac);
+    cv::initUndistortRectifyMap(ctx->cameraMatrix2, ctx->distCoeffs2, ctx->R2, ctx->P2, imageSize, CV_16SC2, ctx->map2xy, ctx->map2frac);
+
+    return ctx;
+}
+
+std::shared_ptr<const RectificationContext> RectificationContext::fromFile(const std::string& filename,
+                                                                          const cv::Size& imageSize) {
+    cv::Mat cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T;
+    if (!loadCalibration(filename, cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T)) {
+        return nullptr;
+    }
+
+    return fromCalibration(cameraMatrix1, distCoeffs1, cameraMatrix2, distCoeffs2, R, T, imageSize);
+}
+
+// Ecriture du bundle binaire
+bool RectificationContext::saveBundle(const std::string& filename) const {
+    std::vector<std::pair<std::string, cv::Mat>> mats;
+    for (size_t i = 0 ; i < NB_BUNDLE_MATS ; i++) {
+        const cv::Mat& mat = this->*BUNDLE_MATS[i].mat;
+        mats.push_back(std::make_pair(BUNDLE_MATS[i].name, mat.isContinuous() ? mat : mat.clone()));
+    }
+    mats.push_back(std::make_pair("roi1", rectToMat(roi1)));
+    mats.push_back(std::make_pair("roi2", rectToMat(roi2)));
+
+    BundleHeader header;
+    std::memcpy(header.magic, BUNDLE_MAGIC, sizeof(header.magic));
+    header.version = BUNDLE_VERSION;
+    header.nbEntries = (uint32_t)mats.size();
+    header.width = imageSize.width;
+    header.height = imageSize.height;
+
+    std::vector<BundleEntry> entries(mats.size());
+    size_t offset = align(sizeof(BundleHeader) + entries.size() * sizeof(BundleEntry));
+    for (size_t i = 0 ; i < mats.size() ; i++) {
+        std::memset(&entries[i], 0, sizeof(BundleEntry));
+        std::strncpy(entries[i].name, mats[i].first.c_str(), sizeof(entries[i].name) - 1);
+        entries[i].type = mats[i].second.type();
+        entries[i].rows = mats[i].second.rows;
+        entries[i].cols = mats[i].second.cols;
+        entries[i].offset = offset;
+        entries[i].size = mats[i].second.total() * mats[i].second.elemSize();
+        offset = align(offset + entries[i].size);
+    }
+
+    // Ecriture dans un fichier temporaire pour que le rechargement ne lise jamais un bundle incomplet
+    std::string tmpFilename = filename + ".tmp";
+    {
+        std::ofstream out(tmpFilename, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Erreur : impossible d'écrire " << tmpFilename << std::endl;
+            return false;
+        }
+
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)entries.data(), entries.size() * sizeof(BundleEntry));
+        for (size_t i = 0 ; i < mats.size() ; i++) {
+            // Remplissage jusqu'à l'alignement
+            std::vector<char> padding(entries[i].offset - (size_t)out.tellp(), 0);
+            out.write(padding.data(), padding.size());
+            out.write((const char*)mats[i].second.data, entries[i].size);
+        }
+
+        if (!out) {
+            std::cerr << "Erreur : écriture de " << tmpFilename << " incomplète" << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpFilename, filename, error);
+    if (error) {
+        std::cerr << "Erreur : " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Lecture du bundle : les matrices pointent directement dans le fichier projeté
+std::shared_ptr<const RectificationContext> RectificationContext::fromBundle(const std::string& filename,
+                                                                            const cv::Size& imageSize) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BundleHeader)) {
+        close(fd);
+        return nullptr;
+    }
+
+    size_t fileSize = (size_t)st.st_size;
+    void* base = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return nullptr;
+
+    std::shared_ptr<void> mapping(base, [fileSize](void* p) { munmap(p, fileSize); });
+    const uchar* bytes = (const uchar*)base;
+
+    // Vérification de l'en-tête
+    const BundleHeader* header = (const BundleHeader*)bytes;
+    if (std::memcmp(header->magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0 ||
+        header->version != BUNDLE_VERSION ||
+        header->width != imageSize.width || header->height != imageSize.height ||
+        sizeof(BundleHeader) + (size_t)header->nbEntries * sizeof(BundleEntry) > fileSize) {
+        return nullptr;
+    }
+
+    std::shared_ptr<RectificationContext> ctx(new RectificationContext());
+    ctx->imageSize = imageSize;
+    ctx->mapping = mapping;
+
+    const BundleEntry* entries = (const BundleEntry*)(bytes + sizeof(BundleHeader));
+    for (uint32_t i = 0 ; i < header->nbEntries ; i++) {
+        const BundleEntry& entry = entries[i];
+        std::string name(entry.name, strnlen(entry.name, sizeof(entry.name)));
+        if (entry.rows < 0 || entry.cols < 0 || entry.offset > fileSize || entry.size > fileSize - entry.offset) {
+            return nullptr;
+        }
+
+        // Matrice vide (non calculée) : son type n'a pas de sens
+        if (entry.rows == 0 || entry.cols == 0) {
+            if (entry.size != 0) return nullptr;
+            continue;
+        }
+
+        // Type validé avant tout calcul de taille : un bundle corrompu est refusé, sans exception d'OpenCV
+        int type = bundleType(name);
+        if (type < 0) continue;
+        if (entry.type != type || (size_t)entry.rows * entry.cols * CV_ELEM_SIZE(type) != entry.size) {
+            return nullptr;
+        }
+
+        // Pas de copie : les données restent dans la projection mémoire (lecture seule)
+        cv::Mat mat(entry.rows, entry.cols, type, (void*)(bytes + entry.offset));
+
+        if (name == "roi1") {
+            ctx->roi1 = matToRect(mat);
+        } else if (name == "roi2") {
+            ctx->roi2 = matToRect(mat);
+        } else {
+            for (size_t j = 0 ; j < NB_BUNDLE_MATS ; j++) {
+                if (name == BUNDLE_MATS[j].name) (*ctx).*BUNDLE_MATS[j].mat = mat;
+            }
+        }
+    }
+
+    // Cartes de la taille des images (la partie fractionnaire est facultative) : cv::remap
+    // échouerait sinon dans le thread de rectification. Q sert à la reprojection des obstacles
+    if (ctx->map1xy.size() != imageSize || ctx->map2xy.size() != imageSize ||
+        (!ctx->map1frac.empty() && ctx->map1frac.size() != imageSize) ||
+        (!ctx->map2frac.empty() && ctx->map2frac.size() != imageSize) ||
+        ctx->Q.size() != cv::Size(4, 4)) {
+        return nullptr;
+    }
+
+    return ctx;
+}
@@ -0,0 +1,152 @@
+#include "SharedFrameClient.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+SharedFrameClient::~SharedFrameClient() {
+    close();
+}
+
+bool SharedFrameClient::open(const std::string& pair, const std::string& stream) {
+    close();
+    pairName = pair;
+    streamName = stream;
+    name = sharedRingName(pair, stream);
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SharedRingHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    // Segment incomplet (service en cours de démarrage) ou d'une autre version
+    const SharedRingHeader* ring = (const SharedRingHeader*)mapping;
+    bool valid = memcmp(ring->magic, SHARED_RING_MAGIC, sizeof(ring->magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && ring->version == SHARED_RING_VERSION && ring->slotCount > 0 &&
+            sizeof(SharedRingHeader) + ring->slotCount * ring->slotStride <= (size_t)info.st_size;
+    if (!valid) {
+        munmap(mapping, info.st_size);
+        return false;
+    }
+
+    base = mapping;
+    size = info.st_size;
+    header = ring;
+    inode = info.st_ino;
+    lastWrites = 0;
+    return true;
+}
+
+void SharedFrameClient::close() {
+    if (base != nullptr) munmap(base, size);
+    base = nullptr;
+    header = nullptr;
+    size = 0;
+}
+
+bool SharedFrameClient::isOpen() const {
+    return header != nullptr;
+}
+
+// Côté lecteur du seqlock : stamp attendu avant, métadonnées, stamp inchangé après
+bool SharedFrameClient::latest(SharedFrame& frame) const {
+    if (header == nullptr) return false;
+
+    // L'écrivain peut repasser sur l'emplacement pendant la lecture : quelques essais
+    for (int attempt = 0 ; attempt < 4 ; attempt++) {
+        uint64_t writes = header->writes.load(std::memory_order_acquire);
+        if (writes == 0) return false;
+        uint64_t index = writes - 1;
+        const SharedSlotHeader* slot = sharedSlot(base, header, index % header->slotCount);
+
+        uint64_t stamp = slot->stamp.load(std::memory_order_acquire);
+        if (stamp != 2 * index + 2) continue;
+        frame.seq = slot->seq.load(std::memory_order_relaxed);
+        frame.timestamp = slot->timestamp.load(std::memory_order_relaxed);
+        frame.width = slot->width.load(std::memory_order_relaxed);
+        frame.height = slot->height.load(std::memory_order_relaxed);
+        frame.type = slot->type.load(std::memory_order_relaxed);
+        frame.step = slot->step.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->stamp.load(std::memory_order_relaxed) != stamp) continue;
+
+        frame.data = (const char*)slot + sizeof(SharedSlotHeader);
+        frame.slot = slot;
+        frame.stamp = stamp;
+        return true;
+    }
+    return false;
+}
+
+bool SharedFrameClient::isValid(const SharedFrame& frame) const {
+    if (frame.slot == nullptr) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return frame.slot->stamp.load(std::memory_order_relaxed) == frame.stamp;
+}
+
+bool SharedFrameClient::copyLatest(SharedFrame& frame, std::vector<uint8_t>& buffer) const {
+    for (int attempt = 0 ; attempt < 4 ; attempt++) {
+        if (!latest(frame)) return false;
+        size_t bytes = (size_t)frame.step * frame.height;
+        buffer.resize(bytes);
+        memcpy(buffer.data(), frame.data, bytes);
+        if (!isValid(frame)) continue;
+
+        frame.data = buffer.data();
+        return true;
+    }
+    return false;
+}
+
+bool SharedFrameClient::waitForFrame(SharedFrame& frame, int timeoutMs) {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while (true) {
+        if (header != nullptr) {
+            uint64_t writes = header->writes.load(std::memory_order_acquire);
+            if (writes != lastWrites && latest(frame)) {
+                lastWrites = writes;
+                return true;
+            }
+        }
+
+        // Rien de nouveau : le service a peut-être recréé le segment
+        if (std::chrono::steady_clock::now() >= deadline) {
+            if (replaced()) open(pairName, streamName);
+            return false;
+        }
+        // Une milliseconde reste très petite devant l'intervalle entre deux images
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+uint64_t SharedFrameClient::getWrites() const {
+    return header ? header->writes.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t SharedFrameClient::getDropped() const {
+    return header ? header->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+// Le nom désigne un autre segment que celui projeté (ou n'existe plus)
+bool SharedFrameClient::replaced() const {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return header != nullptr;
+    struct stat info;
+    bool different = fstat(fd, &info) != 0 || info.st_ino != inode || header == nullptr;
+    ::close(fd);
+    return different;
+}
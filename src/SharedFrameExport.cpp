@@ -0,0 +1,136 @@
+#include "SharedFrameExport.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const char* STREAM_NAMES[NB_RECORD_STREAMS] = {"left", "right", "disparity"};
+
+SharedFrameExport::SharedFrameExport(CaptureManager* captureManager, const StereoPairConfig& pair, int slotCount)
+    : captureManager(captureManager), pair(pair), slotCount(std::max(2, slotCount)) {
+    for (int i = 0 ; i < NB_RECORD_STREAMS ; i++) {
+        rings[i].name = sharedRingName(pair.name, STREAM_NAMES[i]);
+    }
+
+    observer = captureManager->addFrameObserver(
+        [this](int camID, uint64_t seq, int64_t timestamp, const cv::Mat& frame) {
+            if (camID == this->pair.left) push(RECORD_LEFT, seq, timestamp, frame);
+            if (camID == this->pair.right) push(RECORD_RIGHT, seq, timestamp, frame);
+        });
+}
+
+// Les segments sont retirés : un lecteur encore attaché garde sa projection
+// jusqu'à ce qu'il se détache, et voit le nouveau segment au prochain open
+SharedFrameExport::~SharedFrameExport() {
+    captureManager->removeFrameObserver(observer);
+    for (Ring& ring : rings) {
+        if (ring.header == nullptr) continue;
+        munmap(ring.base, ring.size);
+        shm_unlink(ring.name.c_str());
+    }
+}
+
+void SharedFrameExport::pushDisparity(uint64_t seq, int64_t timestamp, const cv::Mat& disparity) {
+    push(RECORD_DISPARITY, seq, timestamp, disparity);
+}
+
+bool SharedFrameExport::create(Ring& ring, size_t frameBytes) {
+    size_t slotSize = (frameBytes + 63) / 64 * 64;
+    size_t slotStride = sizeof(SharedSlotHeader) + slotSize;
+    size_t size = sizeof(SharedRingHeader) + slotCount * slotStride;
+
+    // Un segment laissé par une exécution précédente peut avoir une autre taille
+    shm_unlink(ring.name.c_str());
+    int fd = shm_open(ring.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Erreur : mémoire partagée " << ring.name << " : " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, size) != 0) {
+        std::cerr << "Erreur : mémoire partagée " << ring.name << " : " << strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(ring.name.c_str());
+        return false;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Erreur : mémoire partagée " << ring.name << " : " << strerror(errno) << std::endl;
+        shm_unlink(ring.name.c_str());
+        return false;
+    }
+
+    // ftruncate remet le segment à zéro : compteurs et stamps sont déjà nuls.
+    // La signature est écrite en dernier, un lecteur ne lit pas un en-tête incomplet.
+    SharedRingHeader* header = (SharedRingHeader*)base;
+    header->version = SHARED_RING_VERSION;
+    header->slotCount = slotCount;
+    header->slotSize = slotSize;
+    header->slotStride = slotStride;
+    header->writerPid = (int32_t)getpid();
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, SHARED_RING_MAGIC, sizeof(header->magic));
+
+    ring.base = base;
+    ring.size = size;
+    ring.header.store(header, std::memory_order_release);
+    return true;
+}
+
+// Côté écrivain du seqlock : stamp impair, copie, stamp pair, puis compteur d'images
+void SharedFrameExport::push(int stream, uint64_t seq, int64_t timestamp, const cv::Mat& image) {
+    Ring& ring = rings[stream];
+    size_t rowBytes = image.cols * image.elemSize();
+    size_t frameBytes = rowBytes * image.rows;
+    if (frameBytes == 0) return;
+    if (ring.header == nullptr) {
+        if (ring.failed) return;
+        ring.failed = !create(ring, frameBytes);
+        if (ring.failed) return;
+    }
+
+    SharedRingHeader* header = ring.header.load(std::memory_order_relaxed);
+    if (frameBytes > header->slotSize) {
+        header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t index = header->writes.load(std::memory_order_relaxed);
+    SharedSlotHeader* slot = sharedSlot(ring.base, header, index % header->slotCount);
+    uchar* data = (uchar*)slot + sizeof(SharedSlotHeader);
+
+    slot->stamp.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->seq.store(seq, std::memory_order_relaxed);
+    slot->timestamp.store(timestamp, std::memory_order_relaxed);
+    slot->width.store(image.cols, std::memory_order_relaxed);
+    slot->height.store(image.rows, std::memory_order_relaxed);
+    slot->type.store(image.type(), std::memory_order_relaxed);
+    slot->step.store((int32_t)rowBytes, std::memory_order_relaxed);
+    if (image.isContinuous()) {
+        memcpy(data, image.data, frameBytes);
+    } else {
+        for (int y = 0 ; y < image.rows ; y++) memcpy(data + y * rowBytes, image.ptr(y), rowBytes);
+    }
+    slot->stamp.store(2 * index + 2, std::memory_order_release);
+    header->writes.store(index + 1, std::memory_order_release);
+}
+
+std::string SharedFrameExport::statusJson() const {
+    std::ostringstream json;
+    json << "[";
+    for (int i = 0 ; i < NB_RECORD_STREAMS ; i++) {
+        const Ring& ring = rings[i];
+        const SharedRingHeader* header = ring.header.load(std::memory_order_acquire);
+        if (i > 0) json << ",";
+        json << "{\"name\":\"" << ring.name << "\""
+             << ",\"writes\":" << (header ? header->writes.load() : 0)
+             << ",\"dropped\":" << (header ? header->dropped.load() : 0)
+             << ",\"bytes\":" << (header ? ring.size : 0) << "}";
+    }
+    json << "]";
+    return json.str();
+}
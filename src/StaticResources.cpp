@@ -0,0 +1,141 @@
+#include "StaticResources.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <vector>
+
+// Les pages peuvent changer à chaque déploiement : le navigateur revalide
+// après une minute, et n'a alors qu'une réponse 304 vide en retour
+static const char* CACHE_CONTROL = "public, max-age=60";
+
+int StaticResources::serve(struct mg_connection *conn, const std::string& name) {
+#ifdef RESOURCES_FROM_DISK
+    return serveFromDisk(conn, name);
+#else
+    const EmbeddedResource* resource = find(name);
+    if (resource == nullptr) {
+        mg_printf(conn,
+                  "HTTP/1.1 404 Not Found\r\n"
+                  "Content-Type: text/plain\r\n\r\n"
+                  "File not found!");
+        return 404;
+    }
+
+    bool gzip = resource->gzipData != nullptr && acceptsGzip(conn);
+    const unsigned char* data = gzip ? resource->gzipData : resource->data;
+    size_t size = gzip ? resource->gzipSize : resource->size;
+    const char* etag = gzip ? resource->gzipEtag : resource->etag;
+
+    // Le navigateur a déjà cette version, dans cet encodage (l'ETag contient ses guillemets)
+    const char* ifNoneMatch = mg_get_header(conn, "If-None-Match");
+    if (ifNoneMatch != nullptr && (strstr(ifNoneMatch, etag) != nullptr || strcmp(ifNoneMatch, "*") == 0)) {
+        mg_printf(conn,
+                  "HTTP/1.1 304 Not Modified\r\n"
+                  "ETag: %s\r\n"
+                  "Cache-Control: %s\r\n"
+                  "Vary: Accept-Encoding\r\n\r\n",
+                  etag, CACHE_CONTROL);
+        return 304;
+    }
+
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: %s\r\n"
+              "%s"
+              "ETag: %s\r\n"
+              "Cache-Control: %s\r\n"
+              "Vary: Accept-Encoding\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              resource->contentType, gzip ? "Content-Encoding: gzip\r\n" : "",
+              etag, CACHE_CONTROL, size);
+    mg_write(conn, data, size);
+    return 200;
+#endif
+}
+
+const EmbeddedResource* StaticResources::find(const std::string& name) {
+    for (size_t i = 0 ; i < NB_EMBEDDED_RESOURCES ; i++) {
+        if (name == EMBEDDED_RESOURCES[i].name) return &EMBEDDED_RESOURCES[i];
+    }
+    return nullptr;
+}
+
+// Accept-Encoding : "gzip" (ou "x-gzip"), à défaut "*", avec une qualité non nulle.
+// Exemples refusés : "gzip;q=0", "gzip; q=0.000", "*;q=0", "identity"
+bool StaticResources::acceptsGzip(struct mg_connection *conn) {
+    const char* acceptEncoding = mg_get_header(conn, "Accept-Encoding");
+    if (acceptEncoding == nullptr) return false;
+
+    double gzipQuality = -1, anyQuality = -1;
+    std::string header(acceptEncoding);
+    size_t start = 0;
+    while (start <= header.size()) {
+        size_t end = header.find(',', start);
+        if (end == std::string::npos) end = header.size();
+        std::string item = header.substr(start, end - start);
+        start = end + 1;
+
+        // Codage, puis paramètres séparés par des ';' (seul q nous intéresse)
+        size_t separator = item.find(';');
+        std::string coding = trim(item.substr(0, separator));
+        double quality = 1;
+        while (separator != std::string::npos) {
+            size_t next = item.find(';', separator + 1);
+            std::string parameter = trim(item.substr(separator + 1, next == std::string::npos ? std::string::npos
+                                                                                               : next - separator - 1));
+            if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+                quality = atof(parameter.c_str() + 2);
+            }
+            separator = next;
+        }
+
+        if (strcasecmp(coding.c_str(), "gzip") == 0 || strcasecmp(coding.c_str(), "x-gzip") == 0) {
+            gzipQuality = std::max(gzipQuality, quality);
+        } else if (coding == "*") {
+            anyQuality = quality;
+        }
+    }
+
+    return gzipQuality >= 0 ? gzipQuality > 0 : anyQuality > 0;
+}
+
+std::string StaticResources::trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+// Mode développement : relecture du fichier, sans cache
+int StaticResources::serveFromDisk(struct mg_connection *conn, const std::string& name) {
+    std::string path = "resources/" + name;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) {
+        mg_printf(conn,
+                  "HTTP/1.1 404 Not Found\r\n"
+                  "Content-Type: text/plain\r\n\r\n"
+                  "File not found!");
+        return 404;
+    }
+
+    // Lire le contenu du fichier
+    fseek(file, 0, SEEK_END);
+    size_t fileSize = ftell(file);
+    rewind(file);
+    std::vector<char> fileContent(fileSize);
+    size_t read = fread(fileContent.data(), 1, fileSize, file);
+    fclose(file);
+
+    const EmbeddedResource* resource = find(name);
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: %s\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Content-Length: %zu\r\n\r\n",
+              resource != nullptr ? resource->contentType : "text/html", read);
+    mg_write(conn, fileContent.data(), read);
+    return 200;
+}
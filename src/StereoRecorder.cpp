@@ -0,0 +1,405 @@
+#include "StereoRecorder.hpp"
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Format de l'enregistrement (ordre des octets natif, blocs alignés sur 64 octets) :
+// en-tête, blocs (en-tête de bloc puis image brute), index, puis marque de fin
+const char RECORD_MAGIC[8] = {'P', 'V', 'R', 'E', 'C', '\0', '\0', '\0'};
+const char INDEX_MAGIC[8] = {'P', 'V', 'R', 'I', 'D', 'X', '\0', '\0'};
+const uint32_t RECORD_VERSION = 1;
+const uint32_t BLOCK_MARKER = 0x4b4c4250;  // "PBLK"
+const size_t RECORD_ALIGN = 64;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    char pair[48];
+};
+
+struct BlockHeader {
+    uint32_t marker;
+    uint32_t stream;
+    int32_t type;
+    int32_t rows;
+    int32_t cols;
+    int32_t reserved;
+    uint64_t seq;
+    int64_t timestamp;
+    uint64_t size;
+};
+
+struct IndexEntry {
+    uint32_t stream;
+    int32_t type;
+    int32_t rows;
+    int32_t cols;
+    uint64_t seq;
+    int64_t timestamp;
+    uint64_t offset;  // Début des données de l'image
+};
+
+struct Trailer {
+    char magic[8];
+    uint64_t indexOffset;
+    uint64_t count;
+};
+
+size_t align(size_t offset) {
+    return (offset + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+}
+
+// Remplissage jusqu'à l'alignement suivant
+void writePadding(std::ofstream& out, uint64_t& position) {
+    static const char zeros[RECORD_ALIGN] = {0};
+    size_t padding = align(position) - position;
+    out.write(zeros, padding);
+    position += padding;
+}
+
+const char* STREAM_NAMES[NB_RECORD_STREAMS] = {"left", "right", "disparity"};
+
+// Types possibles de chaque flux : images des caméras (couleur ou niveaux de gris), disparité brute
+bool knownType(uint32_t stream, int type) {
+    if (stream == RECORD_LEFT || stream == RECORD_RIGHT) return type == CV_8UC3 || type == CV_8UC1;
+    return stream == RECORD_DISPARITY && type == CV_16SC1;
+}
+
+// Taille des données d'une image d'après son type et ses dimensions, 0 si elles sont invalides.
+// Le type est vérifié avant CV_ELEM_SIZE et les dimensions bornées : pas de débordement
+size_t imageSize(uint32_t stream, int type, int rows, int cols) {
+    const int MAX_DIMENSION = 1 << 15;
+    if (!knownType(stream, type) || rows <= 0 || cols <= 0 || rows > MAX_DIMENSION || cols > MAX_DIMENSION) return 0;
+    return (size_t)rows * cols * CV_ELEM_SIZE(type);
+}
+
+}
+
+StereoRecorder::Stream::Stream(int nbSlots) : freeSlots(nbSlots), pending(nbSlots), written(0), dropped(0) {
+    for (int i = 0 ; i < nbSlots ; i++) {
+        slots.emplace_back(new Slot());
+        freeSlots.push(slots.back().get());
+    }
+}
+
+StereoRecorder::StereoRecorder(CaptureManager* captureManager, const StereoPairConfig& pair, int slotsPerStream)
+    : captureManager(captureManager), pair(pair), recording(false), withDisparity(false), bytesWritten(0), failed(false) {
+    for (int i = 0 ; i < NB_RECORD_STREAMS ; i++) {
+        streams[i].reset(new Stream(slotsPerStream));
+    }
+
+    // Les images des deux caméras de la paire arrivent directement du thread de capture
+    observer = captureManager->addFrameObserver(
+        [this](int camID, uint64_t seq, int64_t timestamp, const cv::Mat& frame) {
+            if (camID == this->pair.left) push(RECORD_LEFT, seq, timestamp, frame);
+            if (camID == this->pair.right) push(RECORD_RIGHT, seq, timestamp, frame);
+        });
+}
+
+StereoRecorder::~StereoRecorder() {
+    captureManager->removeFrameObserver(observer);
+    stop();
+}
+
+bool StereoRecorder::isRecording() const {
+    return recording;
+}
+
+// Côté producteur : une copie dans un emplacement libre, ou l'image est perdue
+void StereoRecorder::push(int stream, uint64_t seq, int64_t timestamp, const cv::Mat& image) {
+    if (!recording) return;
+
+    Stream& s = *streams[stream];
+    Slot* slot;
+    if (!s.freeSlots.pop(slot)) {
+        s.dropped++;
+        return;
+    }
+
+    slot->seq = seq;
+    slot->timestamp = timestamp;
+    image.copyTo(slot->image); // Pas d'allocation une fois l'emplacement utilisé
+    s.pending.push(slot);
+    writerSignal.notify();
+}
+
+void StereoRecorder::pushDisparity(uint64_t seq, int64_t timestamp, const cv::Mat& disparity) {
+    if (withDisparity) push(RECORD_DISPARITY, seq, timestamp, disparity);
+}
+
+bool StereoRecorder::start(const std::string& filename, bool withDisparity) {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (recording) return false;
+
+    // Écrivain arrêté seul sur une erreur d'écriture
+    if (writer.joinable()) writer.join();
+    failed = false;
+    failure.clear();
+
+    // Les images arrivées après l'arrêt précédent sont abandonnées
+    for (auto& stream : streams) {
+        Slot* slot;
+        while (stream->pending.pop(slot)) stream->freeSlots.push(slot);
+        stream->written = 0;
+        stream->dropped = 0;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+    out.open(filename, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Erreur : impossible d'écrire " << filename << std::endl;
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, RECORD_MAGIC, sizeof(header.magic));
+    header.version = RECORD_VERSION;
+    std::strncpy(header.pair, pair.name.c_str(), sizeof(header.pair) - 1);
+    out.write((const char*)&header, sizeof(header));
+
+    this->filename = filename;
+    this->withDisparity = withDisparity;
+    bytesWritten = sizeof(header);
+    recording = true;
+    writer = TaskScheduler::instance().spawn(pair.name + "/recorder", STAGE_SERVICE, [this]() { writerThread(); });
+
+    std::cout << "Enregistrement de " << pair.name << " dans " << filename << std::endl;
+    return true;
+}
+
+void StereoRecorder::stop() {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (!writer.joinable()) return;
+
+    recording = false;
+    writerSignal.wakeAll();
+    writer.join();
+
+    std::cout << "Fin de l'enregistrement de " << pair.name << " :";
+    for (int i = 0 ; i < NB_RECORD_STREAMS ; i++) {
+        std::cout << " " << STREAM_NAMES[i] << " " << streams[i]->written << " (" << streams[i]->dropped << " perdues)";
+    }
+    std::cout << std::endl;
+}
+
+// Thread d'écriture : vide les files en ajoutant les blocs à la suite du fichier
+void StereoRecorder::writerThread() {
+    std::vector<IndexEntry> index;
+    uint64_t position = bytesWritten;
+
+    while (true) {
+        // Dort tant qu'aucune image n'attend ; lu avant de vider les files,
+        // l'arrêt ne fait rien perdre de ce qui le précède
+        writerSignal.wait([this]() {
+            if (!recording) return true;
+            for (auto& stream : streams) {
+                if (stream->pending.size() > 0) return true;
+            }
+            return false;
+        });
+        bool active = recording;
+
+        for (int i = 0 ; i < NB_RECORD_STREAMS && !failed ; i++) {
+            Stream& stream = *streams[i];
+            Slot* slot;
+            while (stream.pending.pop(slot)) {
+                const cv::Mat& image = slot->image;
+
+                BlockHeader block;
+                std::memset(&block, 0, sizeof(block));
+                block.marker = BLOCK_MARKER;
+                block.stream = (uint32_t)i;
+                block.type = image.type();
+                block.rows = image.rows;
+                block.cols = image.cols;
+                block.seq = slot->seq;
+                block.timestamp = slot->timestamp;
+                block.size = image.total() * image.elemSize();
+
+                out.write((const char*)&block, sizeof(block));
+                position += sizeof(block);
+                writePadding(out, position);
+                index.push_back({block.stream, block.type, block.rows, block.cols, block.seq, block.timestamp, position});
+                out.write((const char*)image.data, block.size);
+                position += block.size;
+                writePadding(out, position);
+                stream.freeSlots.push(slot);
+
+                // Disque plein... : inutile de continuer, l'enregistrement s'arrête
+                if (!out) {
+                    failure = "écriture impossible après " + std::to_string(position) + " octets : " +
+                              std::strerror(errno);
+                    failed = true;
+                    recording = false;
+                    std::cerr << "Erreur : " << filename << " : " << failure << std::endl;
+                    break;
+                }
+                stream.written++;
+            }
+        }
+        bytesWritten = position;
+
+        if (failed) {
+            out.close();
+            return;
+        }
+        if (!active) break;
+    }
+
+    // L'index et la marque de fin rendent l'accès direct possible sans relire les blocs
+    Trailer trailer;
+    std::memcpy(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic));
+    trailer.indexOffset = position;
+    trailer.count = index.size();
+    out.write((const char*)index.data(), index.size() * sizeof(IndexEntry));
+    out.write((const char*)&trailer, sizeof(trailer));
+    bytesWritten = position + index.size() * sizeof(IndexEntry) + sizeof(trailer);
+
+    if (!out) {
+        std::cerr << "Erreur : écriture de " << filename << " incomplète" << std::endl;
+    }
+    out.close();
+}
+
+std::string StereoRecorder::statusJson() {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    std::ostringstream json;
+
+    json << "{\"pair\":\"" << pair.name << "\""
+         << ",\"recording\":" << (recording ? "true" : "false");
+    if (failed) json << ",\"error\":\"" << failure << "\"";
+    json << ",\"disparity\":" << (withDisparity ? "true" : "false")
+         << ",\"file\":\"" << filename << "\""
+         << ",\"bytes\":" << bytesWritten
+         << ",\"streams\":{";
+    for (int i = 0 ; i < NB_RECORD_STREAMS ; i++) {
+        if (i > 0) json << ",";
+        json << "\"" << STREAM_NAMES[i] << "\":{\"written\":" << streams[i]->written
+             << ",\"dropped\":" << streams[i]->dropped
+             << ",\"queue\":" << streams[i]->pending.size() << "}";
+    }
+    json << "}}";
+    return json.str();
+}
+
+// Lecture : l'index est pris en fin de fichier, ou reconstruit bloc par bloc
+std::shared_ptr<const RecordingReader> RecordingReader::open(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+        close(fd);
+        return nullptr;
+    }
+
+    size_t fileSize = (size_t)st.st_size;
+    void* base = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return nullptr;
+
+    std::shared_ptr<void> mapping(base, [fileSize](void* p) { munmap(p, fileSize); });
+    const uchar* bytes = (const uchar*)base;
+
+    const FileHeader* header = (const FileHeader*)bytes;
+    if (std::memcmp(header->magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0 || header->version != RECORD_VERSION) {
+        return nullptr;
+    }
+
+    std::shared_ptr<RecordingReader> reader(new RecordingReader());
+    reader->pairName = std::string(header->pair, strnlen(header->pair, sizeof(header->pair)));
+    reader->bytes = bytes;
+    reader->mapping = mapping;
+
+    Trailer trailer;
+    bool indexed = false;
+    if (fileSize >= sizeof(FileHeader) + sizeof(Trailer)) {
+        std::memcpy(&trailer, bytes + fileSize - sizeof(Trailer), sizeof(Trailer));
+        indexed = std::memcmp(trailer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+                  trailer.count <= (fileSize - sizeof(Trailer)) / sizeof(IndexEntry) &&
+                  trailer.indexOffset + trailer.count * sizeof(IndexEntry) + sizeof(Trailer) == fileSize;
+    }
+
+    std::vector<IndexEntry> index;
+    if (indexed) {
+        index.resize(trailer.count);
+        std::memcpy(index.data(), bytes + trailer.indexOffset, index.size() * sizeof(IndexEntry));
+    } else {
+        // Enregistrement interrompu : les blocs complets restent lisibles
+        size_t position = sizeof(FileHeader);
+        while (position + sizeof(BlockHeader) <= fileSize) {
+            BlockHeader block;
+            std::memcpy(&block, bytes + position, sizeof(block));
+            size_t offset = align(position + sizeof(block));
+            if (block.marker != BLOCK_MARKER || offset > fileSize || block.size > fileSize - offset ||
+                block.size != imageSize(block.stream, block.type, block.rows, block.cols)) break;
+            index.push_back({block.stream, block.type, block.rows, block.cols, block.seq, block.timestamp, offset});
+            position = align(offset + block.size);
+        }
+        std::cerr << "Attention : " << filename << " sans index, " << index.size() << " image(s) récupérée(s)." << std::endl;
+    }
+
+    // Aucune cv::Mat n'est construite sur une entrée invalide : un fichier corrompu est refusé sans exception
+    for (const IndexEntry& entry : index) {
+        size_t size = imageSize(entry.stream, entry.type, entry.rows, entry.cols);
+        if (size == 0 || entry.offset > fileSize || size > fileSize - entry.offset) {
+            return nullptr;
+        }
+        reader->byStream[entry.stream].push_back(reader->entries.size());
+        reader->entries.push_back({(int)entry.stream, entry.type, entry.rows, entry.cols,
+                                   entry.seq, entry.timestamp, entry.offset});
+    }
+
+    return reader;
+}
+
+const std::string& RecordingReader::getPairName() const {
+    return pairName;
+}
+
+size_t RecordingReader::size() const {
+    return entries.size();
+}
+
+RecordedFrame RecordingReader::frame(size_t i) const {
+    const Entry& entry = entries[i];
+    // Pas de copie : l'image reste dans la projection mémoire
+    cv::Mat image(entry.rows, entry.cols, entry.type, (void*)(bytes + entry.offset));
+    return {entry.stream, entry.seq, entry.timestamp, image};
+}
+
+const std::vector<size_t>& RecordingReader::streamFrames(int stream) const {
+    return byStream[stream];
+}
+
+// Les numéros et horodatages croissent dans chaque flux : recherche dichotomique
+long RecordingReader::findBySeq(int stream, uint64_t seq) const {
+    const std::vector<size_t>& frames = byStream[stream];
+    auto it = std::lower_bound(frames.begin(), frames.end(), seq,
+                               [this](size_t i, uint64_t value) { return entries[i].seq < value; });
+    if (it == frames.end() || entries[*it].seq != seq) return -1;
+    return (long)*it;
+}
+
+long RecordingReader::findByTimestamp(int stream, int64_t timestamp) const {
+    const std::vector<size_t>& frames = byStream[stream];
+    auto it = std::lower_bound(frames.begin(), frames.end(), timestamp,
+                               [this](size_t i, int64_t value) { return entries[i].timestamp < value; });
+    if (it == frames.end()) return -1;
+    return (long)*it;
+}
@@ -0,0 +1,108 @@
+#include "StreamDemand.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+// Le registre est local à une fonction pour ne pas dépendre de l'ordre
+// d'initialisation des variables statiques des contrôleurs
+std::mutex& StreamDemand::registryMutex() {
+    static std::mutex m;
+    return m;
+}
+
+std::vector<StreamDemand*>& StreamDemand::registry() {
+    static std::vector<StreamDemand*> r;
+    return r;
+}
+
+StreamDemand::StreamDemand(const std::string& name) : name(name), subscribers(0), idle(true) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+}
+
+StreamDemand::~StreamDemand() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto& r = registry();
+    r.erase(std::remove(r.begin(), r.end(), this), r.end());
+}
+
+void StreamDemand::subscribe() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        subscribers++;
+    }
+    cond.notify_all();
+}
+
+void StreamDemand::unsubscribe() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (subscribers > 0) subscribers--;
+}
+
+// Attente du premier abonné
+bool StreamDemand::waitForSubscribers(const bool& running) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (subscribers == 0 && !idle) {
+        idle = true;
+        std::cout << "Etape " << name << " en veille." << std::endl;
+    }
+
+    // Réveil périodique pour pouvoir s'arrêter proprement
+    while (subscribers == 0 && running) {
+        cond.wait_for(lock, std::chrono::milliseconds(200));
+    }
+
+    if (subscribers > 0 && idle) {
+        idle = false;
+        std::cout << "Etape " << name << " active." << std::endl;
+    }
+
+    return subscribers > 0;
+}
+
+bool StreamDemand::poll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool active = subscribers > 0;
+
+    if (active == idle) {
+        idle = !active;
+        std::cout << "Etape " << name << (active ? " active." : " en veille.") << std::endl;
+    }
+
+    return active;
+}
+
+const std::string& StreamDemand::getName() const {
+    return name;
+}
+
+int StreamDemand::getSubscribers() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscribers;
+}
+
+bool StreamDemand::isActive() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !idle;
+}
+
+std::string StreamDemand::statusJson() {
+    std::ostringstream json;
+    std::lock_guard<std::mutex> lock(registryMutex());
+
+    json << "[";
+    bool first = true;
+    for (StreamDemand* demand : registry()) {
+        if (!first) json << ",";
+        first = false;
+        json << "{\"stage\":\"" << demand->getName() << "\""
+             << ",\"subscribers\":" << demand->getSubscribers()
+             << ",\"state\":\"" << (demand->isActive() ? "active" : "idle") << "\"}";
+    }
+    json << "]";
+
+    return json.str();
+}
@@ -0,0 +1,355 @@
+#include "TaskScheduler.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <cerrno>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+thread_local int TaskScheduler::workerIndex = -1;
+thread_local bool TaskScheduler::adopted = false;
+
+namespace {
+
+const char* STAGE_CLASS_NAMES[NB_STAGE_CLASSES] = {"capture", "compute", "encode", "service"};
+
+int currentTid() {
+    return (int)syscall(SYS_gettid);
+}
+
+// Lecture du temps CPU (utime + stime, en ticks) et du dernier cœur d'un thread
+bool readThreadStat(int tid, long& ticks, int& cpu) {
+    std::ifstream file("/proc/self/task/" + std::to_string(tid) + "/stat");
+    std::string line;
+    if (!std::getline(file, line)) return false;
+
+    // Le nom du thread peut contenir des espaces : on repart de la dernière parenthèse
+    size_t end = line.rfind(')');
+    if (end == std::string::npos) return false;
+    std::istringstream fields(line.substr(end + 2));
+
+    // Champs à partir de l'état (3e champ) : utime = 14, stime = 15, processor = 39
+    std::string field;
+    long utime = 0, stime = 0;
+    for (int i = 3 ; i <= 39 && fields >> field ; i++) {
+        if (i == 14) utime = std::stol(field);
+        if (i == 15) stime = std::stol(field);
+        if (i == 39) cpu = std::stoi(field);
+    }
+
+    ticks = utime + stime;
+    return true;
+}
+
+}
+
+TaskScheduler::TaskScheduler() : pending(0), nextWorker(0), stopping(false) {
+    config = SchedulerConfig::defaults();
+}
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+const char* TaskScheduler::stageClassName(StageClass stageClass) {
+    return STAGE_CLASS_NAMES[stageClass];
+}
+
+// Lecture de la section "scheduler" du fichier de configuration
+SchedulerConfig SchedulerConfig::load(const std::string& filename) {
+    SchedulerConfig config = defaults();
+
+    cv::FileStorage fs;
+    try {
+        fs.open(filename, cv::FileStorage::READ);
+    } catch (const cv::Exception& e) {
+        return config;
+    }
+    if (!fs.isOpened()) return config;
+
+    cv::FileNode scheduler = fs["scheduler"];
+    if (scheduler.empty()) return config;
+
+    if (!scheduler["workers"].empty()) config.workers = std::max(1, (int)scheduler["workers"]);
+    if (!scheduler["encoders"].empty()) config.encoders = std::max(1, (int)scheduler["encoders"]);
+
+    for (int i = 0 ; i < NB_STAGE_CLASSES ; i++) {
+        cv::FileNode node = scheduler[STAGE_CLASS_NAMES[i]];
+        if (node.empty()) continue;
+
+        if (!node["cpus"].empty()) {
+            config.classes[i].cpus.clear();
+            cv::FileNode cpus = node["cpus"];
+            for (cv::FileNodeIterator it = cpus.begin() ; it != cpus.end() ; ++it) {
+                config.classes[i].cpus.push_back((int)*it);
+            }
+        }
+        if (!node["nice"].empty()) config.classes[i].nice = (int)node["nice"];
+    }
+
+    fs.release();
+    return config;
+}
+
+// Par défaut : tous les cœurs, priorité normale, un thread de calcul par cœur libre
+SchedulerConfig SchedulerConfig::defaults() {
+    SchedulerConfig config;
+    for (int i = 0 ; i < NB_STAGE_CLASSES ; i++) {
+        config.classes[i].nice = 0;
+    }
+    config.workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    config.encoders = 2;
+    return config;
+}
+
+// Démarrage du pool de calcul
+void TaskScheduler::start(const SchedulerConfig& config) {
+    this->config = config;
+    stopping = false;
+
+    for (int i = 0 ; i < config.workers ; i++) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (int i = 0 ; i < config.workers ; i++) {
+        workers[i]->thread = std::thread(&TaskScheduler::workerLoop, this, i);
+    }
+
+    std::cout << "Ordonnanceur : " << config.workers << " thread(s) de calcul." << std::endl;
+}
+
+void TaskScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCond.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+    workers.clear();
+}
+
+// Application des cœurs et de la priorité de la classe au thread courant. Pour un
+// placement temporaire (reversible), une priorité plus basse n'est pas appliquée :
+// sans privilège, le thread ne pourrait plus revenir à sa priorité d'origine
+void TaskScheduler::applyPlacement(StageClass stageClass, bool reversible) {
+    const StageClassConfig& classConfig = config.classes[stageClass];
+
+    if (!classConfig.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        int nbCpus = (int)std::thread::hardware_concurrency();
+        for (int cpu : classConfig.cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE && (nbCpus == 0 || cpu < nbCpus)) CPU_SET(cpu, &set);
+        }
+        if (CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            std::cerr << "Attention : placement impossible pour la classe " << STAGE_CLASS_NAMES[stageClass] << std::endl;
+        }
+    }
+
+    if (reversible) {
+        errno = 0;
+        int current = getpriority(PRIO_PROCESS, currentTid());
+        if (errno != 0 || classConfig.nice >= current) return;
+    }
+    if (classConfig.nice != 0 && setpriority(PRIO_PROCESS, currentTid(), classConfig.nice) != 0) {
+        std::cerr << "Attention : priorité " << classConfig.nice << " refusée pour la classe "
+                  << STAGE_CLASS_NAMES[stageClass] << std::endl;
+    }
+}
+
+void TaskScheduler::registerThread(const std::string& name, StageClass stageClass) {
+    int tid = currentTid();
+    ThreadInfo info;
+    info.name = name;
+    info.stageClass = stageClass;
+    info.ticks = 0;
+    info.sampleTime = std::chrono::steady_clock::now();
+    int cpu = 0;
+    readThreadStat(tid, info.ticks, cpu);
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    threads[tid] = info;
+}
+
+void TaskScheduler::unregisterThread() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    threads.erase(currentTid());
+}
+
+std::thread TaskScheduler::spawn(const std::string& name, StageClass stageClass, std::function<void()> fn) {
+    return std::thread([this, name, stageClass, fn]() {
+        applyPlacement(stageClass);
+        registerThread(name, stageClass);
+        fn();
+        unregisterThread();
+    });
+}
+
+TaskScheduler::Adoption::Adoption(const std::string& name, StageClass stageClass) {
+    active = !adopted;
+    if (!active) return;
+    adopted = true;
+
+    // Placement d'origine, rétabli par le destructeur
+    CPU_ZERO(&previousCpus);
+    cpusSaved = pthread_getaffinity_np(pthread_self(), sizeof(previousCpus), &previousCpus) == 0;
+    errno = 0;
+    previousNice = getpriority(PRIO_PROCESS, currentTid());
+    niceSaved = errno == 0;
+
+    TaskScheduler& scheduler = instance();
+    scheduler.applyPlacement(stageClass, true);
+    scheduler.registerThread(name, stageClass);
+}
+
+TaskScheduler::Adoption::~Adoption() {
+    if (!active) return;
+
+    TaskScheduler& scheduler = instance();
+    scheduler.unregisterThread();
+    if (cpusSaved) pthread_setaffinity_np(pthread_self(), sizeof(previousCpus), &previousCpus);
+    if (niceSaved && getpriority(PRIO_PROCESS, currentTid()) != previousNice) {
+        setpriority(PRIO_PROCESS, currentTid(), previousNice);
+    }
+    adopted = false;
+}
+
+// Ajout d'une tâche : dans la file du worker courant, sinon à tour de rôle
+std::future<void> TaskScheduler::submit(std::function<void()> task) {
+    auto packaged = std::make_shared<std::packaged_task<void()>>(task);
+    std::future<void> future = packaged->get_future();
+
+    // Pool arrêté ou absent : exécution directe
+    if (workers.empty()) {
+        (*packaged)();
+        return future;
+    }
+
+    int index = workerIndex >= 0 ? workerIndex : (int)(nextWorker++ % workers.size());
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back([packaged]() { (*packaged)(); });
+    }
+    pending++;
+    sleepCond.notify_one();
+
+    return future;
+}
+
+// Exécute une tâche : d'abord la sienne (la plus récente), sinon vole la plus ancienne d'un autre
+bool TaskScheduler::tryRunOne() {
+    if (workers.empty()) return false;
+
+    std::function<void()> task;
+    int nbWorkers = (int)workers.size();
+    int start = workerIndex >= 0 ? workerIndex : (int)(nextWorker % nbWorkers);
+
+    if (workerIndex >= 0) {
+        Worker& own = *workers[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    for (int i = 0 ; !task && i < nbWorkers ; i++) {
+        Worker& victim = *workers[(start + i) % nbWorkers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task) return false;
+
+    pending--;
+    task();
+    return true;
+}
+
+void TaskScheduler::workerLoop(int index) {
+    workerIndex = index;
+    applyPlacement(STAGE_COMPUTE);
+    registerThread("worker" + std::to_string(index), STAGE_COMPUTE);
+
+    while (true) {
+        if (tryRunOne()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (stopping) break;
+        sleepCond.wait_for(lock, std::chrono::milliseconds(100), [this] { return pending > 0 || stopping; });
+        if (stopping && pending == 0) break;
+    }
+
+    unregisterThread();
+}
+
+void TaskScheduler::runAll(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) return;
+
+    std::vector<std::future<void>> futures;
+    for (size_t i = 1 ; i < tasks.size() ; i++) {
+        futures.push_back(submit(tasks[i]));
+    }
+
+    // La première tâche est faite par l'appelant
+    tasks[0]();
+
+    for (std::future<void>& future : futures) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!tryRunOne()) future.wait_for(std::chrono::microseconds(200));
+        }
+        future.get(); // Propage les exceptions des tâches
+    }
+}
+
+std::map<int, std::string> TaskScheduler::threadNames() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::map<int, std::string> names;
+    for (auto& entry : threads) names[entry.first] = entry.second.name;
+    return names;
+}
+
+// Utilisation CPU de chaque thread depuis la requête précédente
+std::string TaskScheduler::threadsJson() {
+    std::ostringstream json;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    auto now = std::chrono::steady_clock::now();
+
+    json << "[";
+    bool first = true;
+    for (auto& entry : threads) {
+        ThreadInfo& info = entry.second;
+        long ticks = 0;
+        int cpu = -1;
+        if (!readThreadStat(entry.first, ticks, cpu)) continue;
+
+        double elapsed = std::chrono::duration<double>(now - info.sampleTime).count();
+        double usage = elapsed > 0 ? 100.0 * (ticks - info.ticks) / ticksPerSecond / elapsed : 0.0;
+        info.ticks = ticks;
+        info.sampleTime = now;
+
+        if (!first) json << ",";
+        first = false;
+        json << "{\"name\":\"" << info.name << "\""
+             << ",\"class\":\"" << STAGE_CLASS_NAMES[info.stageClass] << "\""
+             << ",\"tid\":" << entry.first
+             << ",\"cpu\":" << cpu
+             << ",\"cpuSeconds\":" << (double)ticks / ticksPerSecond
+             << ",\"cpuPercent\":" << usage << "}";
+    }
+    json << "]";
+
+    return json.str();
+}
@@ -7,9 +7,15 @@
 #include <random>
 #include <string>
 #include <filesystem>
+#include <vector>
+#include "CaptureManager.hpp"
+#include "TaskScheduler.hpp"
+#include "FramePool.hpp"
+#include "EncodeService.hpp"
 #include "IndexController.hpp"
 #include "CalibrationController.hpp"
 #include "DisparityController.hpp"
+#include "BatchDisparity.hpp"
 #include "commons.hpp"
 
 bool running = true;
@@ -23,13 +29,51 @@ void handleSignal(int signal) {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     // Enregistrement du gestionnaire de signal
     signal(SIGTERM, handleSignal);
     signal(SIGINT, handleSignal);
 
+    // Comptage des allocations de cv::Mat (/pool), avant toute image
+    FramePool::install();
+
+    // Arguments : [--synthetic] [--port N] [cameras.yml]
+    // Mode batch : --batch <dossier|fichier.pvrec> [--output dossier] [--calibration fichier]
+    //              [--census] [--depth] [--threads N]
+    std::string configFile = "./data/cameras.yml";
+    std::string port = "8080";
+    bool synthetic = false;
+    BatchConfig batch;
+    batch.output = "./data/batch";
+    for (int i = 1 ; i < argc ; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--synthetic") synthetic = true;
+        else if (arg == "--port" && hasValue) port = argv[++i];
+        else if (arg == "--batch" && hasValue) batch.input = argv[++i];
+        else if (arg == "--output" && hasValue) batch.output = argv[++i];
+        else if (arg == "--calibration" && hasValue) batch.calibration = argv[++i];
+        else if (arg == "--threads" && hasValue) batch.threads = atoi(argv[++i]);
+        else if (arg == "--census") batch.census = true;
+        else if (arg == "--depth") batch.depth = true;
+        else configFile = arg;
+    }
+
+    // Traitement hors ligne, sans serveur HTTP ni caméra
+    if (!batch.input.empty()) {
+        TaskScheduler::instance().start(SchedulerConfig::load(configFile));
+        if (batch.calibration.empty()) {
+            CaptureConfig captureConfig = CaptureConfig::load(configFile);
+            batch.calibration = captureConfig.pairs.empty() ? "./data/calibration/stereo_calib.yml"
+                              : captureConfig.pairs[0].dataDir + "/calibration/stereo_calib.yml";
+        }
+        int code = BatchDisparity(batch).run();
+        TaskScheduler::instance().stop();
+        return code;
+    }
+
     // Initialise le serveur HTTP
-    const char *options[] = {"listening_ports", "8080", nullptr};
+    const char *options[] = {"listening_ports", port.c_str(), nullptr};
     struct mg_callbacks callbacks = {};
     struct mg_context *ctx = mg_start(&callbacks, nullptr, options);
 
@@ -38,21 +82,49 @@ int main() {
         running = false;
     } else {
         running = true;
-        std::cout << "Serveur démarré sur http://localhost:8080/" << std::endl;
+        std::cout << "Serveur démarré sur http://localhost:" << port << "/" << std::endl;
+    }
+
+    // Caméras et paires stéréo lues à l'exécution ; --synthetic remplace les caméras
+    // par des mires générées (tests de charge sans matériel)
+    SchedulerConfig schedulerConfig = SchedulerConfig::load(configFile);
+    TaskScheduler::instance().start(schedulerConfig);
+    EncodeService::instance().start(schedulerConfig.encoders);
+    CaptureConfig captureConfig = CaptureConfig::load(configFile);
+    if (synthetic) {
+        for (CameraConfig& camera : captureConfig.cameras) camera.source = "synthetic";
     }
+    CaptureManager* captureManager = new CaptureManager(captureConfig);
+
+    IndexController* indexController = new IndexController(ctx, captureManager);
 
-    IndexController* indexController = new IndexController(ctx);
-    CalibrationController* calibrationController = new CalibrationController(ctx, indexController);
-    DisparityController* disparityController = new DisparityController(ctx, indexController);
+    // Une chaîne de calibration et de disparité par paire, la première garde les routes historiques
+    std::vector<DisparityController*> disparityControllers;
+    std::vector<CalibrationController*> calibrationControllers;
+    for (size_t i = 0 ; i < captureManager->getPairs().size() ; i++) {
+        const StereoPairConfig& pair = captureManager->getPairs()[i];
+        DisparityController* disparityController = new DisparityController(ctx, captureManager, pair, i == 0);
+        disparityControllers.push_back(disparityController);
+        calibrationControllers.push_back(new CalibrationController(ctx, captureManager, pair, disparityController, i == 0));
+    }
 
     // Boucle principale pour maintenir le programme actif
     while (running) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
-    delete calibrationController;
-    delete disparityController;
-    delete indexController;
+    // Les handlers HTTP utilisent les contrôleurs : ils sont arrêtés (mg_stop attend leur fin)
+    // avant que les contrôleurs ne soient détruits
+    for (CalibrationController* calibrationController : calibrationControllers) calibrationController->stop();
+    for (DisparityController* disparityController : disparityControllers) disparityController->stop();
+    indexController->stop();
     if (ctx) mg_stop(ctx);
+
+    for (CalibrationController* calibrationController : calibrationControllers) delete calibrationController;
+    for (DisparityController* disparityController : disparityControllers) delete disparityController;
+    delete indexController;
+    EncodeService::instance().stop();
+    delete captureManager;
+    TaskScheduler::instance().stop();
     return 0;
 }
@@ -0,0 +1,88 @@
+// Vérifie que CensusMatcher::compute (vectorisé, par bandes) donne exactement
+// la même disparité que computeReference (scalaire, direct), sur des images
+// aléatoires et sur des paires décalées, pour plusieurs fenêtres et plages de disparité.
+// Code de retour non nul au premier écart : utilisé par ctest.
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <string>
+
+#include "CensusMatcher.hpp"
+
+// Paire texturée : l'image droite est la gauche décalée de shift pixels vers la gauche
+static void shiftedPair(cv::RNG& rng, const cv::Size& size, int shift, cv::Mat& left, cv::Mat& right) {
+    cv::Mat noise(size, CV_8UC1);
+    rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(noise, left, cv::Size(3, 3), 0);
+
+    right.create(size, CV_8UC1);
+    right.setTo(cv::Scalar(0));
+    left(cv::Rect(shift, 0, size.width - shift, size.height)).copyTo(right(cv::Rect(0, 0, size.width - shift, size.height)));
+}
+
+static bool check(const std::string& name, CensusMatcher& matcher, const cv::Mat& left, const cv::Mat& right) {
+    cv::Mat disparity, reference;
+    matcher.compute(left, right, disparity);
+    matcher.computeReference(left, right, reference);
+
+    cv::Mat diff = disparity != reference;
+    int errors = cv::countNonZero(diff);
+    if (errors == 0) {
+        std::cout << "OK    " << name << std::endl;
+        return true;
+    }
+
+    std::vector<cv::Point> points;
+    cv::findNonZero(diff, points);
+    std::cout << "ECHEC " << name << " : " << errors << " pixels différents, premier en ("
+              << points[0].x << ", " << points[0].y << ") : " << disparity.at<short>(points[0])
+              << " au lieu de " << reference.at<short>(points[0]) << std::endl;
+    return false;
+}
+
+int main() {
+    // Petites images : la référence est en O(largeur x hauteur x disparités x fenêtre²)
+    const int windowSizes[] = {3, 7, 15};
+    const int disparities[] = {16, 48};
+    // Largeur non multiple de la taille des registres, hauteur impaire
+    const cv::Size sizes[] = {cv::Size(96, 64), cv::Size(131, 45)};
+    const int threads[] = {1, 4};
+
+    cv::RNG rng(12345);
+    bool ok = true;
+
+    for (int nbThreads : threads) {
+        cv::setNumThreads(nbThreads);
+        for (const cv::Size& size : sizes) {
+            for (int numDisparities : disparities) {
+                for (int windowSize : windowSizes) {
+                    // Le même matcher sert à tous les cas : les buffers conservés ne doivent rien changer
+                    CensusMatcher matcher(numDisparities, windowSize);
+                    std::string config = std::to_string(size.width) + "x" + std::to_string(size.height) +
+                                         " d=" + std::to_string(numDisparities) +
+                                         " w=" + std::to_string(windowSize) +
+                                         " threads=" + std::to_string(nbThreads);
+
+                    cv::Mat left(size, CV_8UC1), right(size, CV_8UC1);
+                    rng.fill(left, cv::RNG::UNIFORM, 0, 256);
+                    rng.fill(right, cv::RNG::UNIFORM, 0, 256);
+                    ok &= check("aléatoire " + config, matcher, left, right);
+
+                    for (int shift : {0, numDisparities / 3, numDisparities - 1}) {
+                        shiftedPair(rng, size, shift, left, right);
+                        ok &= check("décalage " + std::to_string(shift) + " " + config, matcher, left, right);
+                    }
+
+                    // Image uniforme : toutes les disparités ont le même coût
+                    left.setTo(cv::Scalar(128));
+                    right.setTo(cv::Scalar(128));
+                    ok &= check("uniforme " + config, matcher, left, right);
+                }
+            }
+        }
+    }
+
+    std::cout << (ok ? "Tous les cas sont identiques à la référence" : "La version vectorisée diffère de la référence")
+              << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Vérifie le comptage des allocations de FramePool : l'allocateur installé voit
+// les allocations faites dans OpenCV et dans les threads de cv::parallel_for_,
+// et une chaîne rectification + census sur des buffers conservés n'alloue plus
+// rien après la première image ; une image interrompue est comptée quand même.
+// Code de retour non nul en cas d'échec : utilisé par ctest.
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <string>
+
+#include "FramePool.hpp"
+#include "CensusMatcher.hpp"
+
+static bool expect(const std::string& name, bool condition) {
+    std::cout << (condition ? "OK    " : "ECHEC ") << name << std::endl;
+    return condition;
+}
+
+int main() {
+    FramePool::install();
+    cv::setNumThreads(4);
+    bool ok = true;
+
+    // Allocation directe, puis réutilisation d'un buffer de la bonne taille
+    cv::Mat buffer;
+    FramePool::beginFrame();
+    FramePool::ensure(buffer, cv::Size(64, 48), CV_8UC1);
+    ok &= expect("allocation comptée", FramePool::endFrame("direct") == 1);
+    FramePool::beginFrame();
+    FramePool::ensure(buffer, cv::Size(64, 48), CV_8UC1);
+    ok &= expect("buffer réutilisé", FramePool::endFrame("direct") == 0);
+
+    // Allocation faite par OpenCV dans une sortie vide
+    cv::Mat color(48, 64, CV_8UC3, cv::Scalar(10, 20, 30)), gray;
+    FramePool::beginFrame();
+    cv::cvtColor(color, gray, cv::COLOR_BGR2GRAY);
+    ok &= expect("allocation d'OpenCV comptée", FramePool::endFrame("opencv") == 1);
+
+    // Image interrompue (sortie anticipée) : elle est terminée et comptée quand même
+    for (int i = 0 ; i < 2 ; i++) {
+        FramePool::Frame frame("interrompue");
+        cv::Mat temporary(8, 8, CV_8UC1);
+        if (i == 0) continue;
+    }
+    std::string stats = FramePool::statsJson();
+    ok &= expect("image interrompue comptée",
+                 stats.find("{\"stage\":\"interrompue\",\"frames\":2,\"allocations\":2") != std::string::npos);
+
+    // Chaîne de la disparité : conversion, rectification, census, normalisation
+    cv::Size size(320, 240);
+    cv::Mat frame(size, CV_8UC3), rectified, disparity16, disparity8;
+    cv::RNG rng(12345);
+    rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+    cv::Mat cameraMatrix = (cv::Mat_<double>(3, 3) << 300, 0, 160, 0, 300, 120, 0, 0, 1);
+    cv::Mat mapxy, mapfrac;
+    cv::initUndistortRectifyMap(cameraMatrix, cv::Mat(), cv::Mat(), cameraMatrix, size, CV_16SC2, mapxy, mapfrac);
+    CensusMatcher census(32, 9);
+
+    // Les bandes du census sont créées dans les threads d'OpenCV : elles doivent compter pour l'image
+    long unattributed = FramePool::unattributedAllocations();
+    for (int i = 0 ; i < 5 ; i++) {
+        FramePool::beginFrame();
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        cv::remap(gray, rectified, mapxy, mapfrac, cv::INTER_LINEAR);
+        census.compute(rectified, rectified, disparity16);
+        cv::normalize(disparity16, disparity8, 0, 255, cv::NORM_MINMAX, CV_8U);
+        long allocations = FramePool::endFrame("disparity");
+
+        if (i == 0) {
+            ok &= expect("première image : buffers alloués (" + std::to_string(allocations) + ")", allocations > 0);
+        } else {
+            ok &= expect("image " + std::to_string(i) + " : aucune allocation (" + std::to_string(allocations) + ")",
+                         allocations == 0);
+        }
+    }
+
+    ok &= expect("aucune allocation hors image pendant les calculs",
+                 FramePool::unattributedAllocations() == unattributed);
+
+    std::cout << FramePool::statsJson() << std::endl;
+    return ok ? 0 : 1;
+}